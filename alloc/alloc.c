@@ -1,14 +1,53 @@
 #include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "cl_params.h"
 
 #define EXIT_NO_ARG 1
 #define EXIT_NO_MEM 2
+#define EXIT_NO_LOCK 3
+#define EXIT_NO_THREAD 4
+
+#define LOCK_NONE 0
+#define LOCK_MLOCK 1
+#define LOCK_ONFAULT 2
+#define LOCK_ALL 3
+
+#ifndef MLOCK_ONFAULT
+#define MLOCK_ONFAULT 0x01
+#endif
+
+#define PATTERN_PERIOD 26
+#define MAX_REPORTED_MISMATCHES 16
+
+typedef struct {
+    char *c;
+    long begin;
+    long end;
+} FillRange;
 
 void fill(char *c, long size);
+void fill_threaded(char *c, long size, int nr_threads);
+void *fill_range(void *arg);
+long chunk_boundary(long head, long chunk, int chunk_nr, long size);
+void pause_step(long seconds, long microseconds);
+void lock(char *c, long size, int mode);
+void unlock(char *c, long size, int mode);
+void exit_lock_limit(void);
+long locked_size(void);
+uint64_t checksum(const char *c, long size);
+long verify(const char *c, long size);
+double wtime(void);
 
 int main(int argc, char *argv[]) {
     long mem;
@@ -20,24 +59,317 @@ int main(int argc, char *argv[]) {
         errx(EXIT_NO_ARG, "no -maxMem specified");
     if (params.incr < 0)
         params.incr = params.maxMem;
+    if (params.threads < 1)
+        errx(EXIT_NO_ARG, "-threads expects a positive number");
+    if (params.sleep < 0 || params.usleep < 0)
+        errx(EXIT_NO_ARG, "-sleep and -usleep expect a non-negative number");
+    if (params.lock < LOCK_NONE || params.lock > LOCK_ALL)
+        errx(EXIT_NO_ARG, "-lock expects 0 (none), 1 (mlock), "
+                          "2 (mlock2 on fault) or 3 (mlockall)");
+    if (params.lock == LOCK_ALL)
+        lock(NULL, 0, params.lock);
     for (mem = params.incr; mem <= params.maxMem; mem += params.incr) {
         char *c;
-        if ((c = (char *) malloc(mem*sizeof(char))) == NULL)
-            errx(EXIT_NO_MEM, "can't allocate %ld bytes", mem);
+        double start, alloc_time, fill_time;
+        start = wtime();
+        if ((c = (char *) malloc(mem*sizeof(char))) == NULL) {
+            if (params.lock != LOCK_ALL)
+                errx(EXIT_NO_MEM, "can't allocate %ld bytes", mem);
+            /* with all memory locked, the kernel refuses allocations
+               beyond the limit on locked memory */
+            warn("can't allocate %ld bytes with all memory locked, "
+                 "%ld bytes locked", mem, locked_size());
+            exit_lock_limit();
+        }
+        alloc_time = wtime() - start;
         printf("%ld bytes allocated succesfully\n", mem);
         fflush(stdout);
-        fill(c, mem);
+        if (params.lock == LOCK_MLOCK || params.lock == LOCK_ONFAULT)
+            lock(c, mem, params.lock);
+        start = wtime();
+        fill_threaded(c, mem, params.threads);
+        fill_time = wtime() - start;
         printf("%ld bytes written succesfully\n", mem);
+        printf("step %ld bytes: allocated in %.6f s, filled in %.6f s "
+               "by %d threads, %.3f GB/s\n",
+               mem, alloc_time, fill_time, params.threads,
+               mem/fill_time/1.0e9);
         fflush(stdout);
-        sleep(params.sleep);
+        if (params.verify)
+            verify(c, mem);
+        pause_step(params.sleep, params.usleep);
+        if (params.verify)
+            verify(c, mem);
+        unlock(c, mem, params.lock);
         free(c);
     }
+    if (params.lock == LOCK_ALL)
+        munlockall();
     finalizeCL(&params);
     return EXIT_SUCCESS;
 }
 
 void fill(char *c, long size) {
+    FillRange range = {c, 0, size};
+    fill_range(&range);
+}
+
+/* split the buffer in chunks, one per thread, with boundaries on page
+   addresses, so that each thread faults in and writes its own pages, the
+   pattern is the same as for a serial fill */
+void fill_threaded(char *c, long size, int nr_threads) {
+    long page_size = sysconf(_SC_PAGESIZE);
+    long chunk = ((size + nr_threads - 1)/nr_threads + page_size - 1)/
+                 page_size*page_size;
+    long head = (page_size - (long) ((uintptr_t) c % page_size)) % page_size;
+    pthread_t *threads;
+    FillRange *ranges;
+    int thread_nr, status;
+    if (nr_threads == 1) {
+        fill(c, size);
+        return;
+    }
+    threads = (pthread_t *) malloc(nr_threads*sizeof(pthread_t));
+    ranges = (FillRange *) malloc(nr_threads*sizeof(FillRange));
+    if (threads == NULL || ranges == NULL)
+        errx(EXIT_NO_MEM, "can't allocate data for %d threads", nr_threads);
+    for (thread_nr = 0; thread_nr < nr_threads; thread_nr++) {
+        ranges[thread_nr].c = c;
+        ranges[thread_nr].begin = thread_nr == 0 ? 0 :
+                                  chunk_boundary(head, chunk, thread_nr, size);
+        ranges[thread_nr].end = thread_nr == nr_threads - 1 ? size :
+                                chunk_boundary(head, chunk, thread_nr + 1,
+                                               size);
+        if ((status = pthread_create(&threads[thread_nr], NULL, fill_range,
+                                     &ranges[thread_nr])) != 0)
+            errx(EXIT_NO_THREAD, "can't create thread %d: %s",
+                 thread_nr, strerror(status));
+    }
+    for (thread_nr = 0; thread_nr < nr_threads; thread_nr++)
+        pthread_join(threads[thread_nr], NULL);
+    free(ranges);
+    free(threads);
+}
+
+/* offset of the start of chunk chunk_nr, the first page boundary in the
+   buffer is at offset head */
+long chunk_boundary(long head, long chunk, int chunk_nr, long size) {
+    long offset = head + chunk_nr*chunk;
+    return offset < size ? offset : size;
+}
+
+void *fill_range(void *arg) {
+    FillRange *range = (FillRange *) arg;
     long i;
-    for (i = 0; i < size; i++)
-        c[i] = 'A' + (i % 26);
+    for (i = range->begin; i < range->end; i++)
+        range->c[i] = 'A' + (i % 26);
+    return NULL;
+}
+
+/* sleep for the given number of seconds and microseconds, resume when
+   interrupted by a signal */
+void pause_step(long seconds, long microseconds) {
+    struct timespec remaining;
+    remaining.tv_sec = seconds + microseconds/1000000;
+    remaining.tv_nsec = 1000*(microseconds % 1000000);
+    while (nanosleep(&remaining, &remaining) != 0 && errno == EINTR)
+        ;
+}
+
+/* lock the memory with mlock, mlock2 with MLOCK_ONFAULT, or lock all
+   current and future mappings with mlockall, in which case c and size
+   are ignored, report the time it took, or the
+   limit when the kernel refuses */
+void lock(char *c, long size, int mode) {
+    double start = wtime();
+    int status = 0;
+    if (mode == LOCK_MLOCK) {
+        status = mlock(c, size);
+    } else if (mode == LOCK_ONFAULT) {
+#ifdef SYS_mlock2
+        status = syscall(SYS_mlock2, c, size, MLOCK_ONFAULT);
+#else
+        status = -1;
+        errno = ENOSYS;
+#endif
+    } else if (mode == LOCK_ALL) {
+        status = mlockall(MCL_CURRENT | MCL_FUTURE);
+    }
+    if (status != 0) {
+        if (mode == LOCK_ALL)
+            warn("can't lock all memory, %ld bytes locked", locked_size());
+        else
+            warn("can't lock %ld bytes, %ld bytes locked",
+                 size, locked_size());
+        exit_lock_limit();
+    }
+    if (mode == LOCK_ALL)
+        printf("all memory locked in %.6f s, %ld bytes locked\n",
+               wtime() - start, locked_size());
+    else
+        printf("%ld bytes locked in %.6f s\n", size, wtime() - start);
+    fflush(stdout);
+}
+
+/* report RLIMIT_MEMLOCK and exit after memory could not be locked */
+void exit_lock_limit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+            limit.rlim_cur != RLIM_INFINITY)
+        errx(EXIT_NO_LOCK, "RLIMIT_MEMLOCK = %ld bytes",
+             (long) limit.rlim_cur);
+    else
+        errx(EXIT_NO_LOCK, "RLIMIT_MEMLOCK = unlimited");
+}
+
+/* unlock before free, since malloc may reuse the pages, memory locked
+   with mlockall stays locked until munlockall */
+void unlock(char *c, long size, int mode) {
+    if (mode == LOCK_MLOCK || mode == LOCK_ONFAULT)
+        munlock(c, size);
+}
+
+/* VmLck of the process in bytes, 0 if it can't be determined */
+long locked_size(void) {
+    char line[256];
+    long size = 0;
+    FILE *fp;
+    if ((fp = fopen("/proc/self/status", "r")) == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp))
+        if (sscanf(line, "VmLck: %ld kB", &size) == 1)
+            break;
+    fclose(fp);
+    return 1024*size;
+}
+
+/* XXH64 with seed 0, the checksum is only compared against itself,
+   so byte order does not matter */
+#define XXH_PRIME_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME_3 0x165667B19E3779F9ULL
+#define XXH_PRIME_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const char *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input*XXH_PRIME_2;
+    acc = xxh_rotl(acc, 31);
+    return acc*XXH_PRIME_1;
+}
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t value) {
+    acc ^= xxh_round(0, value);
+    return acc*XXH_PRIME_1 + XXH_PRIME_4;
+}
+
+uint64_t checksum(const char *c, long size) {
+    const char *p = c;
+    const char *end = c + size;
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t v1 = XXH_PRIME_1 + XXH_PRIME_2;
+        uint64_t v2 = XXH_PRIME_2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - XXH_PRIME_1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+        }
+        hash = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) +
+               xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        hash = xxh_merge_round(hash, v1);
+        hash = xxh_merge_round(hash, v2);
+        hash = xxh_merge_round(hash, v3);
+        hash = xxh_merge_round(hash, v4);
+    } else {
+        hash = XXH_PRIME_5;
+    }
+    hash += (uint64_t) size;
+    for (; p + 8 <= end; p += 8) {
+        hash ^= xxh_round(0, xxh_read64(p));
+        hash = xxh_rotl(hash, 27)*XXH_PRIME_1 + XXH_PRIME_4;
+    }
+    if (p + 4 <= end) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        hash ^= (uint64_t) value*XXH_PRIME_1;
+        hash = xxh_rotl(hash, 23)*XXH_PRIME_2 + XXH_PRIME_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        hash ^= (unsigned char) *p*XXH_PRIME_5;
+        hash = xxh_rotl(hash, 11)*XXH_PRIME_1;
+    }
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/* read back the buffer page by page, compare the checksum of each page
+   to that of the pattern written by fill, and report bandwidth and
+   mismatching pages */
+long verify(const char *c, long size) {
+    long page_size = sysconf(_SC_PAGESIZE);
+    long offset = 0, nr_bad_pages = 0, phase;
+    uint64_t page_checksums[PATTERN_PERIOD];
+    double start, duration;
+    char *expected;
+    if ((expected = (char *) malloc(page_size + PATTERN_PERIOD)) == NULL)
+        errx(EXIT_NO_MEM, "can't allocate %ld bytes",
+             page_size + PATTERN_PERIOD);
+    fill(expected, page_size + PATTERN_PERIOD);
+    for (phase = 0; phase < PATTERN_PERIOD; phase++)
+        page_checksums[phase] = checksum(expected + phase, page_size);
+    start = wtime();
+    while (offset < size) {
+        const char *page = c + offset;
+        long page_offset = (long) ((uintptr_t) page % page_size);
+        long length = page_size - page_offset;
+        uint64_t expected_checksum;
+        if (length > size - offset)
+            length = size - offset;
+        phase = offset % PATTERN_PERIOD;
+        if (length == page_size)
+            expected_checksum = page_checksums[phase];
+        else
+            expected_checksum = checksum(expected + phase, length);
+        if (checksum(page, length) != expected_checksum) {
+            if (nr_bad_pages < MAX_REPORTED_MISMATCHES)
+                printf("mismatch in page %p\n",
+                       (const void *) (page - page_offset));
+            nr_bad_pages++;
+        }
+        offset += length;
+    }
+    duration = wtime() - start;
+    if (nr_bad_pages > MAX_REPORTED_MISMATCHES)
+        printf("%ld more mismatching pages\n",
+               nr_bad_pages - MAX_REPORTED_MISMATCHES);
+    printf("%ld bytes verified in %.6f s, %.3f GB/s, "
+           "%ld mismatching pages\n",
+           size, duration, size/duration/1.0e9, nr_bad_pages);
+    fflush(stdout);
+    free(expected);
+    return nr_bad_pages;
+}
+
+double wtime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0e-9*ts.tv_nsec;
 }
@@ -12,6 +12,10 @@ void initCL(Params *params) {
 	params->maxMem = -1;
 	params->incr = -1;
 	params->sleep = 0;
+	params->usleep = 0;
+	params->threads = 1;
+	params->verify = 0;
+	params->lock = 0;
 }
 
 void parseCL(Params *params, int *argc, char **argv[]) {
@@ -56,6 +60,50 @@ void parseCL(Params *params, int *argc, char **argv[]) {
 			i++;
 			continue;
 		}
+		if (!strncmp((*argv)[i], "-usleep", 8)) {
+			shiftCL(&i, *argc, *argv);
+			argv_str = (*argv)[i];
+			if (!isLongCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-usleep' of type long\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->usleep = atol(argv_str);
+			i++;
+			continue;
+		}
+		if (!strncmp((*argv)[i], "-threads", 9)) {
+			shiftCL(&i, *argc, *argv);
+			argv_str = (*argv)[i];
+			if (!isIntCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-threads' of type int\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->threads = atoi(argv_str);
+			i++;
+			continue;
+		}
+		if (!strncmp((*argv)[i], "-verify", 8)) {
+			shiftCL(&i, *argc, *argv);
+			argv_str = (*argv)[i];
+			if (!isIntCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-verify' of type int\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->verify = atoi(argv_str);
+			i++;
+			continue;
+		}
+		if (!strncmp((*argv)[i], "-lock", 6)) {
+			shiftCL(&i, *argc, *argv);
+			argv_str = (*argv)[i];
+			if (!isIntCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-lock' of type int\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->lock = atoi(argv_str);
+			i++;
+			continue;
+		}
 		break;
 	}
 	if (i > 1) {
@@ -100,6 +148,38 @@ void parseFileCL(Params *params, char *fileName) {
 			params->sleep = atol(argv_str);
 			continue;
 		}
+		if (sscanf(line_str, "usleep = %[^\n]", argv_str) == 1) {
+			if (!isLongCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-usleep' of type long\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->usleep = atol(argv_str);
+			continue;
+		}
+		if (sscanf(line_str, "threads = %[^\n]", argv_str) == 1) {
+			if (!isIntCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-threads' of type int\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->threads = atoi(argv_str);
+			continue;
+		}
+		if (sscanf(line_str, "verify = %[^\n]", argv_str) == 1) {
+			if (!isIntCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-verify' of type int\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->verify = atoi(argv_str);
+			continue;
+		}
+		if (sscanf(line_str, "lock = %[^\n]", argv_str) == 1) {
+			if (!isIntCL(argv_str, 0)) {
+				fprintf(stderr, "### error: invalid value for option '-lock' of type int\n");
+				exit(EXIT_CL_INVALID_VALUE);
+			}
+			params->lock = atoi(argv_str);
+			continue;
+		}
 		fprintf(stderr, "### warning, line can not be parsed: '%s'\n", line_str);
 	}
 	fclose(fp);
@@ -109,11 +189,15 @@ void dumpCL(FILE *fp, char prefix[], Params *params) {
 	fprintf(fp, "%smaxMem = %ld\n", prefix, params->maxMem);
 	fprintf(fp, "%sincr = %ld\n", prefix, params->incr);
 	fprintf(fp, "%ssleep = %ld\n", prefix, params->sleep);
+	fprintf(fp, "%susleep = %ld\n", prefix, params->usleep);
+	fprintf(fp, "%sthreads = %d\n", prefix, params->threads);
+	fprintf(fp, "%sverify = %d\n", prefix, params->verify);
+	fprintf(fp, "%slock = %d\n", prefix, params->lock);
 }
 
 void finalizeCL(Params *params) {
 }
 
 void printHelpCL(FILE *fp) {
-	fprintf(fp, "  -maxMem <long integer>\n  -incr <long integer>\n  -sleep <long integer>\n  -?: print this message");
+	fprintf(fp, "  -maxMem <long integer>\n  -incr <long integer>\n  -sleep <long integer>\n  -usleep <long integer>\n  -threads <integer>\n  -verify <integer>\n  -lock <integer>\n  -?: print this message");
 }
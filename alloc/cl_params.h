@@ -7,6 +7,10 @@ typedef struct {
 	long maxMem;
 	long incr;
 	long sleep;
+	long usleep;
+	int threads;
+	int verify;
+	int lock;
 } Params;
 
 void initCL(Params *params);
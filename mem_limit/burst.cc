@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "burst.h"
+
+const char *CGROUP_EVENT_NAMES[NR_CGROUP_EVENTS] {
+    "high",
+    "max",
+    "oom",
+    "oom_kill",
+};
+
+// mount point of the cgroup hierarchies, the paths in /proc/self/cgroup
+// are relative to it when a cgroup namespace is used
+const std::string CGROUP_ROOT {"/sys/fs/cgroup"};
+
+// directory of the memory cgroup of the process, v1 is set when it is in
+// the cgroup v1 memory hierarchy, empty when it can't be determined
+static std::string memory_cgroup_dir(bool& v1) {
+    std::ifstream cgroup_file("/proc/self/cgroup");
+    std::string line;
+    std::string v2_dir;
+    while (std::getline(cgroup_file, line)) {
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos)
+            continue;
+        std::string controllers = line.substr(first + 1,
+                                              second - first - 1);
+        std::string path = line.substr(second + 1);
+        std::stringstream stream(controllers);
+        std::string controller;
+        while (std::getline(stream, controller, ',')) {
+            if (controller == "memory") {
+                v1 = true;
+                return CGROUP_ROOT + "/memory" + path;
+            }
+        }
+        if (line.compare(0, 3, "0::") == 0)
+            v2_dir = CGROUP_ROOT + path;
+    }
+    v1 = false;
+    return v2_dir;
+}
+
+void read_cgroup_events(uint64_t events[NR_CGROUP_EVENTS]) {
+    for (int event = 0; event < NR_CGROUP_EVENTS; event++)
+        events[event] = CGROUP_EVENT_UNAVAILABLE;
+    bool v1 {false};
+    std::string dir = memory_cgroup_dir(v1);
+    if (dir.empty())
+        return;
+    std::string name;
+    uint64_t value {0};
+    if (v1) {
+        std::ifstream failcnt_file(dir + "/memory.failcnt");
+        if (failcnt_file >> value)
+            events[CGROUP_EVENT_MAX] = value;
+        std::ifstream oom_file(dir + "/memory.oom_control");
+        while (oom_file >> name >> value)
+            if (name == "oom_kill")
+                events[CGROUP_EVENT_OOM_KILL] = value;
+    } else {
+        std::ifstream events_file(dir + "/memory.events");
+        while (events_file >> name >> value) {
+            for (int event = 0; event < NR_CGROUP_EVENTS; event++)
+                if (name == CGROUP_EVENT_NAMES[event])
+                    events[event] = value;
+        }
+    }
+}
+
+// the 90th percentile is taken by the nearest rank method
+BurstStatistics burst_statistics(const std::vector<double>& times) {
+    BurstStatistics stats {0.0, 0.0, 0.0, 0.0, 0.0, 0};
+    if (times.empty())
+        return stats;
+    std::vector<double> sorted(times);
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    stats.min = sorted.front();
+    stats.max = sorted.back();
+    stats.median = n % 2 == 1 ? sorted[n/2] :
+                                0.5*(sorted[n/2 - 1] + sorted[n/2]);
+    for (auto time: sorted)
+        stats.mean += time;
+    stats.mean /= n;
+    size_t p90_index = static_cast<size_t>(std::ceil(0.9*n));
+    stats.p90 = sorted[p90_index > 0 ? p90_index - 1 : 0];
+    stats.max_rank = std::max_element(times.begin(), times.end()) -
+                     times.begin();
+    return stats;
+}
+
+std::string format_cgroup_events(const uint64_t events[NR_CGROUP_EVENTS]) {
+    std::stringstream ss;
+    for (int event = 0; event < NR_CGROUP_EVENTS; event++) {
+        if (event > 0)
+            ss << " ";
+        ss << CGROUP_EVENT_NAMES[event] << "=";
+        if (events[event] == CGROUP_EVENT_UNAVAILABLE) {
+            ss << "n/a";
+        } else {
+            ss << events[event];
+        }
+    }
+    return ss.str();
+}
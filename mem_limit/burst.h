@@ -0,0 +1,40 @@
+#ifndef BURST_HDR
+#define BURST_HDR
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// events of the memory cgroup of the process, counted by the kernel
+// since the cgroup was created
+enum CgroupEvent {
+    CGROUP_EVENT_HIGH = 0,    // throttled for exceeding memory.high
+    CGROUP_EVENT_MAX,         // charges that hit memory.max, or failcnt
+    CGROUP_EVENT_OOM,         // memory.max hit and reclaim failed
+    CGROUP_EVENT_OOM_KILL,    // processes killed by the OOM killer
+    NR_CGROUP_EVENTS
+};
+
+extern const char *CGROUP_EVENT_NAMES[NR_CGROUP_EVENTS];
+
+// value reported for an event the cgroup version doesn't count
+const uint64_t CGROUP_EVENT_UNAVAILABLE {UINT64_MAX};
+
+// distribution of the time to resident over the processes of a burst
+struct BurstStatistics {
+    double min;
+    double median;
+    double mean;
+    double p90;
+    double max;
+    int max_rank;           // process that took longest
+};
+
+// read the event counts of the memory cgroup of the process, from
+// memory.events for cgroup v2, or memory.failcnt and memory.oom_control
+// for cgroup v1; events that can't be read are CGROUP_EVENT_UNAVAILABLE
+void read_cgroup_events(uint64_t events[NR_CGROUP_EVENTS]);
+BurstStatistics burst_statistics(const std::vector<double>& times);
+std::string format_cgroup_events(const uint64_t events[NR_CGROUP_EVENTS]);
+
+#endif
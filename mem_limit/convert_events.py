@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+
+from argparse import ArgumentParser
+import struct
+import sys
+
+# layout of EventLogHeader and Event in event_log.h
+HEADER_FORMAT = '=8sii256s'
+EVENT_FORMAT = '=QQ8Qiiii'
+MAGIC = b'MLEVT001'
+
+EVENT_ALLOCATING = 0
+EVENT_FILLING = 1
+EVENT_VERIFIED = 2
+EVENT_MISMATCH = 3
+EVENT_MISMATCH_MORE = 4
+EVENT_COUNTERS = 5
+EVENT_LOCKED = 6
+
+# order of the counters in an EVENT_COUNTERS event, see perf_counters.h
+COUNTER_NAMES = ['cycles', 'instructions', 'dtlb_load_misses',
+                 'dtlb_store_misses', 'llc_misses', 'page_faults']
+COUNTER_UNAVAILABLE = 2**64 - 1
+PHASE_ALLOCATE = 0
+
+# names of the lock modes in an EVENT_LOCKED event, see mem_utils.h
+LOCK_MODES = ['none', 'mlock', 'onfault', 'all']
+
+
+def read_events(file_name):
+    with open(file_name, 'rb') as log_stream:
+        header_size = struct.calcsize(HEADER_FORMAT)
+        magic, rank, record_size, name = struct.unpack(
+            HEADER_FORMAT, log_stream.read(header_size)
+        )
+        if magic != MAGIC:
+            raise ValueError("'{0}' is not an event log".format(file_name))
+        if record_size != struct.calcsize(EVENT_FORMAT):
+            msg = "'{0}' has records of {1:d} bytes, expected {2:d}"
+            raise ValueError(msg.format(file_name, record_size,
+                                        struct.calcsize(EVENT_FORMAT)))
+        processor_name = name.split(b'\0', 1)[0].decode('ascii', 'replace')
+        events = []
+        while True:
+            record = log_stream.read(record_size)
+            if len(record) < record_size:
+                break
+            fields = struct.unpack(EVENT_FORMAT, record)
+            events.append({
+                'time': fields[0],
+                'size': fields[1],
+                'data': fields[2:10],
+                'type': fields[10],
+                'rank': fields[11],
+                'thread': fields[12],
+                'cpu': fields[13],
+            })
+    events.sort(key=lambda event: event['time'])
+    return processor_name, events
+
+
+def format_event(event, processor_name):
+    '''format an event as mem_limit writes it to standard output, this
+       must be kept in sync with format_event in event_log.cc'''
+    prefix = 'rank {0:d}#{1:d} on {2:d}@{3}: '.format(
+        event['rank'], event['thread'], event['cpu'], processor_name
+    )
+    if event['type'] == EVENT_ALLOCATING:
+        text = 'allocating {0:d} bytes'.format(event['size'])
+    elif event['type'] == EVENT_FILLING:
+        text = 'filling {0:d} bytes'.format(event['size'])
+    elif event['type'] == EVENT_VERIFIED:
+        duration = 1.0e-9*event['data'][1]
+        text = ('verified {0:d} bytes in {1:g} s, {2:g} GB/s, '
+                '{3:d} mismatching pages').format(
+                    event['size'], duration,
+                    event['size']/duration/1.0e9, event['data'][0]
+                )
+    elif event['type'] == EVENT_MISMATCH:
+        text = 'mismatch in page 0x{0:x}'.format(event['data'][0])
+    elif event['type'] == EVENT_MISMATCH_MORE:
+        text = '{0:d} more mismatching pages'.format(event['data'][0])
+    elif event['type'] == EVENT_LOCKED:
+        text = 'locked {0:d} bytes with {1} in {2:g} s'.format(
+            event['size'], LOCK_MODES[event['data'][1]],
+            1.0e-9*event['data'][0]
+        )
+    elif event['type'] == EVENT_COUNTERS:
+        phase = 'allocate' if event['data'][6] == PHASE_ALLOCATE else 'fill'
+        counters = []
+        for name, value in zip(COUNTER_NAMES, event['data']):
+            if value == COUNTER_UNAVAILABLE:
+                value = 'n/a'
+            counters.append('{0}={1}'.format(name, value))
+        text = 'counters {0} {1:d} bytes: {2}'.format(
+            phase, event['size'], ' '.join(counters)
+        )
+    else:
+        text = 'unknown event {0:d}'.format(event['type'])
+    return prefix + text
+
+
+if __name__ == '__main__':
+    arg_parser = ArgumentParser(description='convert binary mem_limit '
+                                            'event logs to text output')
+    arg_parser.add_argument('files', nargs='+',
+                            help='event log files to convert')
+    arg_parser.add_argument('--frame', action='store_true',
+                            help='enclose output in ==== lines, as '
+                                 'expected by check_pinning.py')
+    options = arg_parser.parse_args()
+    if options.frame:
+        print('====')
+    for file_name in options.files:
+        try:
+            processor_name, events = read_events(file_name)
+        except (IOError, ValueError, struct.error) as e:
+            msg = "### error: can't read '{0}': {1}\n"
+            sys.stderr.write(msg.format(file_name, str(e)))
+            sys.exit(1)
+        for event in events:
+            print(format_event(event, processor_name))
+    if options.frame:
+        print('====')
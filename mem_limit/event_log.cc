@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+
+#include "event_log.h"
+#include "mem_utils.h"
+#include "perf_counters.h"
+
+// time the writer waits when there are no events to write
+const std::chrono::milliseconds EVENT_LOG_FLUSH_INTERVAL {10};
+
+void EventRing::push(const Event& event) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (head - tail_.load(std::memory_order_acquire) >= events_.size())
+        std::this_thread::yield();
+    events_[head % events_.size()] = event;
+    head_.store(head + 1, std::memory_order_release);
+}
+
+size_t EventRing::write(FILE *file) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t nr_events = head - tail;
+    while (tail < head) {
+        size_t pos = tail % events_.size();
+        size_t count = std::min(head - tail, events_.size() - pos);
+        fwrite(&events_[pos], sizeof(Event), count, file);
+        tail += count;
+    }
+    tail_.store(tail, std::memory_order_release);
+    return nr_events;
+}
+
+EventLog::EventLog(const std::string& file_name, int rank,
+                   const char *processor_name, int nr_threads,
+                   size_t capacity) :
+    start_ {std::chrono::steady_clock::now()}, is_done_ {false} {
+    if ((file_ = fopen(file_name.c_str(), "wb")) == nullptr) {
+        std::stringstream ss;
+        ss << "unable to open event log '" << file_name << "'";
+        throw std::runtime_error(ss.str());
+    }
+    EventLogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic));
+    header.rank = rank;
+    header.record_size = sizeof(Event);
+    strncpy(header.processor_name, processor_name,
+            EVENT_LOG_NAME_LENGTH - 1);
+    fwrite(&header, sizeof(header), 1, file_);
+    for (int thread_nr = 0; thread_nr < nr_threads; thread_nr++)
+        rings_.emplace_back(new EventRing(capacity));
+    writer_ = std::thread(&EventLog::write_events, this);
+}
+
+EventLog::~EventLog() {
+    is_done_.store(true, std::memory_order_release);
+    writer_.join();
+    fclose(file_);
+}
+
+void EventLog::log(Event& event) {
+    auto now = std::chrono::steady_clock::now();
+    event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - start_).count();
+    rings_.at(event.thread)->push(event);
+}
+
+void EventLog::write_events() {
+    bool is_done {false};
+    do {
+        is_done = is_done_.load(std::memory_order_acquire);
+        size_t nr_events {0};
+        for (auto& ring: rings_)
+            nr_events += ring->write(file_);
+        if (nr_events == 0 && !is_done)
+            std::this_thread::sleep_for(EVENT_LOG_FLUSH_INTERVAL);
+    } while (!is_done);
+    fflush(file_);
+}
+
+std::string event_log_name(const std::string& prefix, int rank) {
+    std::stringstream ss;
+    ss << prefix << "." << rank << ".evt";
+    return ss.str();
+}
+
+// format an event as the text mem_limit writes to standard output, this
+// must be kept in sync with convert_events.py
+std::string format_event(const Event& event, const char *processor_name) {
+    std::stringstream msg;
+    msg << "rank " << event.rank << "#" << event.thread
+        << " on " << event.cpu << "@" << processor_name << ": ";
+    switch (event.type) {
+        case EVENT_ALLOCATING:
+            msg << "allocating " << event.size << " bytes";
+            break;
+        case EVENT_FILLING:
+            msg << "filling " << event.size << " bytes";
+            break;
+        case EVENT_VERIFIED: {
+            double duration = 1.0e-9*event.data[1];
+            msg << "verified " << event.size << " bytes in "
+                << duration << " s, "
+                << event.size/duration/1.0e9 << " GB/s, "
+                << event.data[0] << " mismatching pages";
+            break;
+        }
+        case EVENT_MISMATCH:
+            msg << "mismatch in page 0x" << std::hex << event.data[0]
+                << std::dec;
+            break;
+        case EVENT_MISMATCH_MORE:
+            msg << event.data[0] << " more mismatching pages";
+            break;
+        case EVENT_LOCKED:
+            msg << "locked " << event.size << " bytes with "
+                << lock_mode_to_string(event.data[1]) << " in "
+                << 1.0e-9*event.data[0] << " s";
+            break;
+        case EVENT_COUNTERS:
+            msg << "counters "
+                << (event.data[6] == PHASE_ALLOCATE ? "allocate" : "fill")
+                << " " << event.size << " bytes: "
+                << format_counters(event.data);
+            break;
+        default:
+            msg << "unknown event " << event.type;
+    }
+    msg << std::endl;
+    return msg.str();
+}
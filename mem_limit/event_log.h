@@ -0,0 +1,101 @@
+#ifndef EVENT_LOG_HDR
+#define EVENT_LOG_HDR
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// magic string at the start of an event log file, the last characters
+// encode the version of the file format
+const char EVENT_LOG_MAGIC[] {"MLEVT001"};
+
+// maximum length of the processor name stored in the log file header
+const int EVENT_LOG_NAME_LENGTH {256};
+
+// default number of events that can be buffered per thread
+const size_t EVENT_LOG_CAPACITY {4096};
+
+enum EventType : int32_t {
+    EVENT_ALLOCATING = 0,     // size: bytes to allocate
+    EVENT_FILLING = 1,        // size: bytes to fill
+    EVENT_VERIFIED = 2,       // size: bytes verified, data[0]: mismatching
+                              // pages, data[1]: duration in ns
+    EVENT_MISMATCH = 3,       // data[0]: address of the mismatching page
+    EVENT_MISMATCH_MORE = 4,  // data[0]: number of unreported mismatches
+    EVENT_COUNTERS = 5,       // data[0-5]: values of the PerfCounter
+                              // counters, data[6]: CounterPhase
+    EVENT_LOCKED = 6,         // size: bytes locked, data[0]: duration in
+                              // ns, data[1]: lock mode
+};
+
+// step a EVENT_COUNTERS event was measured for
+enum CounterPhase : uint64_t {
+    PHASE_ALLOCATE = 0,
+    PHASE_FILL = 1,
+};
+
+// fixed size binary record, written to the log file as is
+struct Event {
+    uint64_t time;            // ns since the log was opened
+    uint64_t size;
+    uint64_t data[8];         // event type specific payload
+    int32_t type;
+    int32_t rank;
+    int32_t thread;
+    int32_t cpu;
+};
+
+// header of an event log file, followed by Event records
+struct EventLogHeader {
+    char magic[8];
+    int32_t rank;
+    int32_t record_size;
+    char processor_name[EVENT_LOG_NAME_LENGTH];
+};
+
+// size of a cache line, used to keep producer and consumer indices apart
+const size_t CACHE_LINE_SIZE {64};
+
+// single producer, single consumer ring buffer of events
+class EventRing {
+    public:
+        explicit EventRing(size_t capacity) :
+            events_(capacity), head_ {0}, tail_ {0} {}
+        void push(const Event& event);
+        size_t write(FILE *file);
+    private:
+        std::vector<Event> events_;
+        std::atomic<size_t> head_;
+        char padding_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> tail_;
+};
+
+// per-rank event log, each thread appends to its own ring buffer, a
+// background thread writes the buffered events to file
+class EventLog {
+    public:
+        EventLog(const std::string& file_name, int rank,
+                 const char *processor_name, int nr_threads,
+                 size_t capacity = EVENT_LOG_CAPACITY);
+        ~EventLog();
+        EventLog(const EventLog&) = delete;
+        EventLog& operator=(const EventLog&) = delete;
+        void log(Event& event);
+    private:
+        void write_events();
+        FILE *file_;
+        std::chrono::steady_clock::time_point start_;
+        std::vector<std::unique_ptr<EventRing>> rings_;
+        std::atomic<bool> is_done_;
+        std::thread writer_;
+};
+
+std::string event_log_name(const std::string& prefix, int rank);
+std::string format_event(const Event& event, const char *processor_name);
+
+#endif
@@ -1,13 +1,13 @@
-#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
-#include <regex>
+#include <memory>
 #include <sstream>
 #include <thread>
 #include <vector>
 #include <string.h>
 #include <sched.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #ifndef NO_MPI
 #include <mpi.h>
@@ -16,23 +16,93 @@
 #include <omp.h>
 #endif
 
+#include "burst.h"
+#include "event_log.h"
+#include "mem_utils.h"
+#include "perf_counters.h"
+#include "thread_ramp.h"
+
 // exit codes for application
 const int EXIT_OPT_ERROR {1};
 const int EXIT_CONFIG_ERROR {2};
 const int EXIT_MEM_ERROR {3};
+const int EXIT_LOG_ERROR {4};
+const int EXIT_LOCK_ERROR {5};
 
 // maximum length for a hostname
 const int MAX_PROCESSOR_NAME {1024};
 
-size_t convert_size(const char *size_spec);
-long convert_time(const char *time_spec);
-char* allocate_memory(size_t size);
-void fill_memory(char *buffer, size_t size);
-void fill_memory_threaded(char *buffer, size_t size);
-void parse_config(const std::string& file_name, int target_line_nr,
-                  size_t& max_size, size_t& increment, long& sleeptime,
-                  int& nr_threads, size_t** max_sizes,
-                  size_t** increments, long** sleeptimes);
+// maximum number of mismatching pages reported per verification
+const size_t MAX_REPORTED_MISMATCHES {16};
+
+// outcome of parsing the command line or a scenario of a sweep
+const int OPTIONS_OK {0};
+const int OPTIONS_DONE {1};
+const int OPTIONS_ERROR {2};
+
+// options for a single run, parsed on the root process from the command
+// line or from a scenario in a sweep file, and broadcast to all processes
+struct Options {
+    std::string conf_file_name;
+    std::string log_prefix;
+    std::string sweep_file_name;
+    std::string results_file_name;
+    int nr_threads {1};
+    size_t max_size {0};
+    size_t increment {0};
+    long sleeptime {0};
+    long lifetime {0};
+    int nr_ramp_threads {0};
+    size_t ramp_stack_size {0};
+    int ramp_touches {0};
+    size_t burst_size {0};
+    long burst_warmup {0};
+    int lock_mode {LOCK_NONE};
+    int is_verbose {0};
+    int is_verifying {0};
+    int is_counting {0};
+};
+
+// results of a single run, summed or maximized over all processes
+struct RunResult {
+    unsigned long nr_threads {0};
+    unsigned long nr_steps {0};
+    unsigned long bytes_filled {0};
+    unsigned long nr_bad_pages {0};
+    unsigned long has_failed {0};
+    double fill_time {0.0};
+    double elapsed {0.0};
+    double burst_time {0.0};
+    uint64_t burst_events[NR_CGROUP_EVENTS] {
+        CGROUP_EVENT_UNAVAILABLE, CGROUP_EVENT_UNAVAILABLE,
+        CGROUP_EVENT_UNAVAILABLE, CGROUP_EVENT_UNAVAILABLE
+    };
+};
+
+int parse_options(int argc, char *argv[], Options& options);
+std::vector<std::string> read_sweep(const std::string& file_name);
+void check_config(const std::string& file_name, int nr_processes);
+void broadcast_options(Options& options, int root);
+RunResult run(const Options& options, int rank, const char *processor_name,
+              bool is_sweep);
+void write_results_header(std::ostream& out);
+void write_result(std::ostream& out, int scenario_nr,
+                  const std::string& scenario, int nr_processes,
+                  const RunResult& result);
+void report_event(EventLog *event_log, Event& event,
+                  const char *processor_name);
+size_t report_verify(const char *buffer, size_t size, Event event,
+                     EventLog *event_log, const char *processor_name);
+void report_lock(char *buffer, size_t size, int lock_mode, Event event,
+                 EventLog *event_log, const char *processor_name);
+int report_allocation_error(size_t size, int lock_mode);
+void report_ramp(int rank, int nr_threads, size_t stack_size, int touches);
+unsigned long report_burst(const Options& options, int rank, int nr_threads,
+                           bool is_sweep, RunResult& result);
+void report_counters(PerfCounters *counters, Event event,
+                     CounterPhase phase, EventLog *event_log,
+                     const char *processor_name);
+void warn_counters(int rank);
 void print_help();
 
 int main(int argc, char *argv[]) {
@@ -51,85 +121,109 @@ int main(int argc, char *argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 #endif
-    char *conf_file_name {nullptr};
-    bool conf_file_allocated {false};
-    size_t proc_max_size {0};
-    size_t proc_increment {0};
-    long  proc_sleeptime {0};
-    int nr_threads {1};
-    size_t max_size {0};
-    size_t *max_sizes {nullptr};
-    size_t increment {0};
-    size_t *increments {nullptr};
-    long sleeptime {0};
-    long *sleeptimes {nullptr};
-    long lifetime {0};
-    int is_verbose {0};
-    int name_length {0};
+    Options cl_options;
+    std::vector<Options> scenarios;
+    std::vector<std::string> scenario_specs;
+    int nr_scenarios {0};
+    int is_sweep {0};
     int is_done = 0;
+    // rows of the results table of a sweep are written as soon as their
+    // scenario is done, so that they survive a later abort or OOM kill
+    std::ofstream results_file;
+    std::ostream *results_out = &std::cout;
     if (rank == root) {
-        bool opt_sufficient {false};
-        char opt {'\0'};
-        while ((opt = getopt(argc, argv, "f:t:m:i:s:l:vh")) != -1) {
+        int status = parse_options(argc, argv, cl_options);
+        if (status == OPTIONS_OK && !cl_options.sweep_file_name.empty()) {
+            is_sweep = 1;
             try {
-                switch (opt) {
-                    case 'f':
-                        conf_file_name = optarg;
-                        name_length = strlen(conf_file_name);
-                        opt_sufficient = true;
-                        break;
-                    case 't':
-                        nr_threads = atoi(optarg);
-                        break;
-                    case 'm':
-                        max_size = convert_size(optarg);
-                        opt_sufficient = true;
-                        break;
-                    case 'i':
-                        increment = convert_size(optarg);
-                        break;
-                    case 's':
-                        sleeptime = convert_time(optarg);
-                        break;
-                    case 'l':
-                        lifetime = convert_time(optarg);
-                        break;
-                    case 'v':
-                        is_verbose = 1;
-                        break;
-                    case 'h':
-                        print_help();
-                        opt_sufficient = 1;
-                        is_done = 1;
-                        break;
-                    default:
-                        std::stringstream msg;
-                        msg << "# error: unknown option '-" << opt << "'"
-                            << std::endl;
-                        std::cerr << msg.str();
-                        print_help();
+                scenario_specs = read_sweep(cl_options.sweep_file_name);
+            } catch (const std::runtime_error& e) {
+                std::stringstream msg;
+                msg << "# error: " << e.what() << std::endl;
+                std::cerr << msg.str();
 #ifndef NO_MPI
-                        MPI_Abort(MPI_COMM_WORLD, EXIT_OPT_ERROR);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_CONFIG_ERROR);
 #endif
-                        std::exit(EXIT_OPT_ERROR);
+                std::exit(EXIT_CONFIG_ERROR);
+            }
+            for (const auto& spec: scenario_specs) {
+                std::vector<std::string> words {"mem_limit"};
+                std::stringstream stream(spec);
+                std::string word;
+                while (stream >> word)
+                    words.push_back(word);
+                std::vector<char*> scenario_argv;
+                for (auto& arg: words)
+                    scenario_argv.push_back(&arg[0]);
+                scenario_argv.push_back(nullptr);
+                Options options {cl_options};
+                options.sweep_file_name.clear();
+                status = parse_options(scenario_argv.size() - 1,
+                                       scenario_argv.data(), options);
+                if (status == OPTIONS_OK &&
+                        !options.sweep_file_name.empty()) {
+                    std::cerr << "# error: -w can't be used in a sweep"
+                              << std::endl;
+                    status = OPTIONS_ERROR;
                 }
-            } catch (const std::invalid_argument& e) {
+                if (status != OPTIONS_OK) {
                     std::stringstream msg;
-                    msg << "# error: invalid option value, " << e.what()
-                        << std::endl;
+                    msg << "# error: invalid scenario '" << spec << "' in '"
+                        << cl_options.sweep_file_name << "'" << std::endl;
                     std::cerr << msg.str();
-                    print_help();
-                    is_done = 1;
+                    status = OPTIONS_ERROR;
+                    break;
+                }
+                scenarios.push_back(options);
             }
+        } else if (status == OPTIONS_OK) {
+            scenarios.push_back(cl_options);
         }
-        if (!opt_sufficient) {
-            std::stringstream msg;
-            msg << "# error: expecting at least -f or -m option"
-                << std::endl;
-            std::cerr << msg.str();
-            print_help();
-            is_done = 1;
+        if (status == OPTIONS_ERROR) {
+#ifndef NO_MPI
+            MPI_Abort(MPI_COMM_WORLD, EXIT_OPT_ERROR);
+#endif
+            std::exit(EXIT_OPT_ERROR);
         }
+        // configuration errors abort the run, so they are found before
+        // the first scenario starts rather than halfway through a sweep
+        for (size_t scenario_nr = 0; is_sweep &&
+                scenario_nr < scenarios.size(); scenario_nr++) {
+            if (scenarios[scenario_nr].conf_file_name.empty())
+                continue;
+            try {
+                check_config(scenarios[scenario_nr].conf_file_name, size);
+            } catch (const std::exception& e) {
+                std::stringstream msg;
+                msg << "# error: invalid configuration in scenario '"
+                    << scenario_specs[scenario_nr] << "', " << e.what()
+                    << std::endl;
+                std::cerr << msg.str();
+#ifndef NO_MPI
+                MPI_Abort(MPI_COMM_WORLD, EXIT_CONFIG_ERROR);
+#endif
+                std::exit(EXIT_CONFIG_ERROR);
+            }
+        }
+        if (is_sweep && !cl_options.results_file_name.empty()) {
+            results_file.open(cl_options.results_file_name);
+            if (!results_file.is_open()) {
+                std::stringstream msg;
+                msg << "# error: unable to open results file '"
+                    << cl_options.results_file_name << "'" << std::endl;
+                std::cerr << msg.str();
+#ifndef NO_MPI
+                MPI_Abort(MPI_COMM_WORLD, EXIT_CONFIG_ERROR);
+#endif
+                std::exit(EXIT_CONFIG_ERROR);
+            }
+            results_out = &results_file;
+        }
+        if (is_sweep) {
+            write_results_header(*results_out);
+        }
+        is_done = status == OPTIONS_DONE;
+        nr_scenarios = scenarios.size();
         if (!is_done) {
             std::stringstream msg;
             msg << "running with " << size << " processes"
@@ -147,26 +241,261 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 #ifndef NO_MPI
-    MPI_Bcast(&is_verbose, 1, MPI_INT, root, MPI_COMM_WORLD);
-    MPI_Bcast(&name_length, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&is_sweep, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&nr_scenarios, 1, MPI_INT, root, MPI_COMM_WORLD);
+#endif
+    scenarios.resize(nr_scenarios);
+    int max_processor_length = MAX_PROCESSOR_NAME;
+#ifndef NO_MPI
+    max_processor_length = MPI_MAX_PROCESSOR_NAME;
+#endif
+    char processor_name[max_processor_length];
+#ifndef NO_MPI
+    int processor_name_len;
+    MPI_Get_processor_name(processor_name, &processor_name_len);
+#else
+    gethostname(processor_name, max_processor_length);
+#endif
+    for (int scenario_nr = 0; scenario_nr < nr_scenarios; scenario_nr++) {
+        Options& options = scenarios[scenario_nr];
+        broadcast_options(options, root);
+        if (is_sweep) {
+            if (!options.log_prefix.empty()) {
+                options.log_prefix += "." + std::to_string(scenario_nr);
+            }
+            if (rank == root) {
+                std::stringstream msg;
+                msg << "scenario " << scenario_nr << ": "
+                    << scenario_specs[scenario_nr] << std::endl;
+                std::cout << msg.str();
+            }
+        }
+        RunResult result = run(options, rank, processor_name, is_sweep);
+        if (is_sweep && rank == root) {
+            write_result(*results_out, scenario_nr,
+                         scenario_specs[scenario_nr], size, result);
+            if (!*results_out) {
+                std::stringstream msg;
+                msg << "# error: unable to write results to '"
+                    << cl_options.results_file_name << "'" << std::endl;
+                std::cerr << msg.str();
+            }
+        }
+    }
+    if (rank == root) {
+        std::stringstream msg;
+        msg << "successfully done" << std::endl;
+        std::cout << msg.str();
+    }
+#ifndef NO_MPI
+    MPI_Finalize();
 #endif
-    if (name_length > 0) {
-        if (rank != root) {
-            conf_file_name = new char[name_length + 1];
-            conf_file_allocated = true;
+    return 0;
+}
+
+int parse_options(int argc, char *argv[], Options& options) {
+    bool opt_sufficient {false};
+    int status {OPTIONS_OK};
+    char opt {'\0'};
+    // glibc fully reinitializes getopt when optind is 0, so that the
+    // scenarios of a sweep can be parsed one after the other
+    optind = 0;
+    while ((opt = getopt(argc, argv, "f:t:m:i:s:l:cL:e:pr:k:x:b:u:w:o:vh")) != -1) {
+        try {
+            switch (opt) {
+                case 'f':
+                    options.conf_file_name = optarg;
+                    opt_sufficient = true;
+                    break;
+                case 't':
+                    options.nr_threads = atoi(optarg);
+                    break;
+                case 'm':
+                    options.max_size = convert_size(optarg);
+                    opt_sufficient = true;
+                    break;
+                case 'i':
+                    options.increment = convert_size(optarg);
+                    break;
+                case 's':
+                    options.sleeptime = convert_time(optarg);
+                    break;
+                case 'l':
+                    options.lifetime = convert_time(optarg);
+                    break;
+                case 'c':
+                    options.is_verifying = 1;
+                    break;
+                case 'L':
+                    options.lock_mode = parse_lock_mode(optarg);
+                    break;
+                case 'e':
+                    options.log_prefix = optarg;
+                    break;
+                case 'p':
+                    options.is_counting = 1;
+                    break;
+                case 'r':
+                    options.nr_ramp_threads = atoi(optarg);
+                    opt_sufficient = true;
+                    break;
+                case 'k':
+                    options.ramp_stack_size = convert_size(optarg);
+                    break;
+                case 'x':
+                    options.ramp_touches = parse_touches(optarg);
+                    break;
+                case 'b':
+                    options.burst_size = convert_size(optarg);
+                    opt_sufficient = true;
+                    break;
+                case 'u':
+                    options.burst_warmup = convert_time(optarg);
+                    break;
+                case 'w':
+                    options.sweep_file_name = optarg;
+                    opt_sufficient = true;
+                    break;
+                case 'o':
+                    options.results_file_name = optarg;
+                    break;
+                case 'v':
+                    options.is_verbose = 1;
+                    break;
+                case 'h':
+                    print_help();
+                    opt_sufficient = true;
+                    status = OPTIONS_DONE;
+                    break;
+                default:
+                    std::stringstream msg;
+                    msg << "# error: unknown option '-" << opt << "'"
+                        << std::endl;
+                    std::cerr << msg.str();
+                    print_help();
+                    return OPTIONS_ERROR;
+            }
+        } catch (const std::invalid_argument& e) {
+                std::stringstream msg;
+                msg << "# error: invalid option value, " << e.what()
+                    << std::endl;
+                std::cerr << msg.str();
+                print_help();
+                status = OPTIONS_DONE;
         }
+    }
+    if (!opt_sufficient && options.conf_file_name.empty() &&
+            options.max_size == 0 && options.nr_ramp_threads == 0 &&
+            options.burst_size == 0) {
+        std::stringstream msg;
+        msg << "# error: expecting at least -f, -m, -r, -b or -w option"
+            << std::endl;
+        std::cerr << msg.str();
+        print_help();
+        status = OPTIONS_DONE;
+    }
+    return status;
+}
+
+// each scenario is a line with mem_limit options, empty lines and lines
+// starting with '#' are ignored
+std::vector<std::string> read_sweep(const std::string& file_name) {
+    std::ifstream sweep_file(file_name);
+    if (!sweep_file.is_open()) {
+        std::stringstream ss;
+        ss << "unable to open sweep file '" << file_name << "'";
+        throw std::runtime_error(ss.str());
+    }
+    std::vector<std::string> specs;
+    std::string line;
+    while (std::getline(sweep_file, line)) {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        specs.push_back(line.substr(start, end - start + 1));
+    }
+    if (specs.empty()) {
+        std::stringstream ss;
+        ss << "no scenarios in sweep file '" << file_name << "'";
+        throw std::runtime_error(ss.str());
+    }
+    return specs;
+}
+
+void broadcast_string(std::string& str, int root) {
+#ifndef NO_MPI
+    int length = str.length();
+    MPI_Bcast(&length, 1, MPI_INT, root, MPI_COMM_WORLD);
+    str.resize(length);
+    if (length > 0)
+        MPI_Bcast(&str[0], length, MPI_CHAR, root, MPI_COMM_WORLD);
+#endif
+}
+
+void broadcast_options(Options& options, int root) {
 #ifndef NO_MPI
-        MPI_Bcast(conf_file_name, name_length + 1, MPI_CHAR,
-                  root, MPI_COMM_WORLD);
+    broadcast_string(options.conf_file_name, root);
+    broadcast_string(options.log_prefix, root);
+    MPI_Bcast(&options.nr_threads, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.max_size, 1, MPI_UNSIGNED_LONG, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.increment, 1, MPI_UNSIGNED_LONG, root,
+              MPI_COMM_WORLD);
+    MPI_Bcast(&options.sleeptime, 1, MPI_LONG, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.lifetime, 1, MPI_LONG, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.nr_ramp_threads, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.ramp_stack_size, 1, MPI_UNSIGNED_LONG, root,
+              MPI_COMM_WORLD);
+    MPI_Bcast(&options.ramp_touches, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.burst_size, 1, MPI_UNSIGNED_LONG, root,
+              MPI_COMM_WORLD);
+    MPI_Bcast(&options.burst_warmup, 1, MPI_LONG, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.lock_mode, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.is_verbose, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.is_verifying, 1, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Bcast(&options.is_counting, 1, MPI_INT, root, MPI_COMM_WORLD);
 #endif
-        if (is_verbose) {
+}
+
+// parse the configuration of each process, to check the configuration
+// file of a scenario before a sweep starts
+void check_config(const std::string& file_name, int nr_processes) {
+    for (int rank = 0; rank < nr_processes; rank++) {
+        size_t max_size {0}, increment {0};
+        long sleeptime {0};
+        int nr_threads {0};
+        size_t *max_sizes {nullptr}, *increments {nullptr};
+        long *sleeptimes {nullptr};
+        parse_config(file_name, rank, max_size, increment, sleeptime,
+                     nr_threads, &max_sizes, &increments, &sleeptimes);
+        delete[] max_sizes;
+        delete[] increments;
+        delete[] sleeptimes;
+    }
+}
+
+// run a single scenario; in a sweep, a failed allocation ends the steps
+// of that thread and is recorded in the result, otherwise it aborts
+RunResult run(const Options& options, int rank, const char *processor_name,
+              bool is_sweep) {
+    const int root {0};
+    auto run_start = std::chrono::steady_clock::now();
+    size_t proc_max_size {0};
+    size_t proc_increment {0};
+    long  proc_sleeptime {0};
+    int nr_threads {options.nr_threads};
+    size_t *max_sizes {nullptr};
+    size_t *increments {nullptr};
+    long *sleeptimes {nullptr};
+    if (!options.conf_file_name.empty()) {
+        if (options.is_verbose) {
             std::stringstream msg;
             msg << "rank " << rank << ": reading "
-                << "'" << conf_file_name << "'" << std::endl;
+                << "'" << options.conf_file_name << "'" << std::endl;
             std::cerr << msg.str();
         }
         try {
-            parse_config(conf_file_name, rank,
+            parse_config(options.conf_file_name, rank,
                          proc_max_size, proc_increment, proc_sleeptime,
                          nr_threads,
                          &max_sizes, &increments, &sleeptimes);
@@ -188,7 +517,7 @@ int main(int argc, char *argv[]) {
 #endif
             std::exit(EXIT_CONFIG_ERROR);
         }
-        if (is_verbose) {
+        if (options.is_verbose) {
             std::stringstream msg;
             msg << "rank " << rank << " running with " << nr_threads << " threads"
                 << std::endl;
@@ -203,31 +532,24 @@ int main(int argc, char *argv[]) {
             std::cerr << msg.str();
         }
     } else {
-#ifndef NO_MPI
-        MPI_Bcast(&nr_threads, 1, MPI_INT, root, MPI_COMM_WORLD);
-        MPI_Bcast(&max_size, 1, MPI_UNSIGNED_LONG, root, MPI_COMM_WORLD);
-        MPI_Bcast(&increment, 1, MPI_UNSIGNED_LONG, root, MPI_COMM_WORLD);
-        MPI_Bcast(&sleeptime, 1, MPI_LONG, root, MPI_COMM_WORLD);
-        MPI_Bcast(&lifetime, 1, MPI_LONG, root, MPI_COMM_WORLD);
-#endif
-        if (is_verbose) {
+        if (options.is_verbose) {
             std::stringstream msg;
             msg << "rank " << rank << ": "
                 << "threads = " << nr_threads << ", "
-                << "max. size = " << max_size << ", "
-                << "increment = " << increment << ", "
-                << "sleep time = " << sleeptime << std::endl;
+                << "max. size = " << options.max_size << ", "
+                << "increment = " << options.increment << ", "
+                << "sleep time = " << options.sleeptime << std::endl;
             std::cerr << msg.str();
         }
-        proc_increment = increment;
-        proc_max_size = max_size;
+        proc_increment = options.increment;
+        proc_max_size = options.max_size;
         max_sizes = new size_t[nr_threads];
         increments = new size_t[nr_threads];
         sleeptimes = new long[nr_threads];
         for (int i = 0; i < nr_threads; i++) {
-            max_sizes[i] = max_size;
-            increments[i] = increment;
-            sleeptimes[i] = sleeptime;
+            max_sizes[i] = options.max_size;
+            increments[i] = options.increment;
+            sleeptimes[i] = options.sleeptime;
         }
     }
     int max_threads {1};
@@ -242,61 +564,170 @@ int main(int argc, char *argv[]) {
             << std::endl;
         std::cout << msg.str();
     }
-    int max_processor_length = MAX_PROCESSOR_NAME;
-#ifndef NO_MPI
-    max_processor_length = MPI_MAX_PROCESSOR_NAME;
+    if (options.nr_ramp_threads > 0) {
+        report_ramp(rank, options.nr_ramp_threads, options.ramp_stack_size,
+                    options.ramp_touches);
+    }
+    if (options.is_counting) {
+        warn_counters(rank);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(nr_threads);
 #endif
-    char processor_name[max_processor_length];
+    RunResult result;
+    unsigned long has_failed {0};
+    // in a sweep, a log file that can't be opened fails the scenario, and
+    // its events are written to standard output instead
+    std::unique_ptr<EventLog> event_log;
+    if (!options.log_prefix.empty()) {
+        try {
+            event_log.reset(new EventLog(
+                        event_log_name(options.log_prefix, rank),
+                        rank, processor_name, nr_threads));
+        } catch (const std::runtime_error& e) {
+            std::stringstream msg;
+            msg << "# error: " << e.what() << std::endl;
+            std::cerr << msg.str();
+            if (is_sweep) {
+                has_failed = 1;
+            } else {
 #ifndef NO_MPI
-    int processor_name_len;
-    MPI_Get_processor_name(processor_name, &processor_name_len);
-#else
-    gethostname(processor_name, max_processor_length);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_LOG_ERROR);
 #endif
-#ifdef _OPENMP
-    omp_set_num_threads(nr_threads);
+                std::exit(EXIT_LOG_ERROR);
+            }
+        }
+    }
+    // mlockall locks the whole process, so it is done once, and also
+    // locks all memory allocated later on
+    if (options.lock_mode == LOCK_ALL) {
+        Event event {};
+        event.rank = rank;
+        try {
+            report_lock(nullptr, 0, options.lock_mode, event,
+                        event_log.get(), processor_name);
+        } catch (const std::runtime_error& e) {
+            std::stringstream msg;
+            msg << "# error: " << e.what() << std::endl;
+            std::cerr << msg.str();
+            if (!is_sweep) {
+#ifndef NO_MPI
+                MPI_Abort(MPI_COMM_WORLD, EXIT_LOCK_ERROR);
 #endif
+                std::exit(EXIT_LOCK_ERROR);
+            }
+            has_failed = 1;
+        }
+    }
+    if (options.burst_size > 0) {
+        has_failed |= report_burst(options, rank, nr_threads, is_sweep,
+                                   result);
+    }
 
-#pragma omp parallel
+    unsigned long nr_bad_pages {0};
+    unsigned long nr_steps {0};
+    unsigned long bytes_filled {0};
+    double fill_time {0.0};
+#pragma omp parallel reduction(+:nr_bad_pages,nr_steps,bytes_filled,fill_time) \
+                     reduction(max:has_failed)
     {
         int thread_nr {0};
 #ifdef _OPENMP
         thread_nr = omp_get_thread_num();
 #endif
+        std::unique_ptr<PerfCounters> counters;
+        if (options.is_counting) {
+            counters.reset(new PerfCounters());
+        }
         size_t increment = increments[thread_nr] > 0 ?
             increments[thread_nr] : max_sizes[thread_nr];
-        for (size_t mem = increment; mem <= max_sizes[thread_nr];
-                mem += increment) {
-            int cpu_nr = sched_getcpu();
-            std::stringstream msg;
-            msg << "rank " << rank << "#" << thread_nr
-                << " on " << cpu_nr << "@" << processor_name << ": "
-                << "allocating " << mem << " bytes" << std::endl;
-            std::cout << msg.str();
+        for (size_t mem = increment; increment > 0 &&
+                mem <= max_sizes[thread_nr]; mem += increment) {
+            Event event {};
+            event.rank = rank;
+            event.thread = thread_nr;
+            event.cpu = sched_getcpu();
+            event.size = mem;
+            event.type = EVENT_ALLOCATING;
+            report_event(event_log.get(), event, processor_name);
             try {
+                if (counters) {
+                    counters->start();
+                }
                 char *buffer = allocate_memory(mem);
-                msg.str("");
-                msg << "rank " << rank << "#" << thread_nr
-                    << " on " << cpu_nr << "@" << processor_name << ": "
-                    << "filling " << mem << " bytes" << std::endl;
-                std::cout << msg.str();
+                if (counters) {
+                    report_counters(counters.get(), event, PHASE_ALLOCATE,
+                                    event_log.get(), processor_name);
+                }
+                if (options.lock_mode == LOCK_MLOCK ||
+                        options.lock_mode == LOCK_ONFAULT) {
+                    try {
+                        report_lock(buffer, mem, options.lock_mode, event,
+                                    event_log.get(), processor_name);
+                    } catch (const std::runtime_error& e) {
+                        free(buffer);
+                        std::stringstream msg;
+                        msg << "# error: " << e.what() << std::endl;
+                        std::cerr << msg.str();
+                        if (is_sweep) {
+                            has_failed = 1;
+                            break;
+                        }
+#ifndef NO_MPI
+                        MPI_Abort(MPI_COMM_WORLD, EXIT_LOCK_ERROR);
+#endif
+                        std::exit(EXIT_LOCK_ERROR);
+                    }
+                }
+                event.type = EVENT_FILLING;
+                report_event(event_log.get(), event, processor_name);
+                if (counters) {
+                    counters->start();
+                }
+                auto fill_start = std::chrono::steady_clock::now();
                 fill_memory(buffer, mem);
+                auto fill_end = std::chrono::steady_clock::now();
+                if (counters) {
+                    report_counters(counters.get(), event, PHASE_FILL,
+                                    event_log.get(), processor_name);
+                }
+                std::chrono::duration<double> duration = fill_end - fill_start;
+                fill_time += duration.count();
+                bytes_filled += mem;
+                nr_steps++;
+                if (options.is_verifying) {
+                    nr_bad_pages += report_verify(buffer, mem, event,
+                                                  event_log.get(),
+                                                  processor_name);
+                }
                 std::chrono::microseconds period(sleeptimes[thread_nr]);
                 std::this_thread::sleep_for(period);
-                delete[] buffer;
+                if (options.is_verifying) {
+                    nr_bad_pages += report_verify(buffer, mem, event,
+                                                  event_log.get(),
+                                                  processor_name);
+                }
+                unlock_memory(buffer, mem, options.lock_mode);
+                free(buffer);
             } catch (const std::runtime_error& e) {
-                std::stringstream msg;
-                msg << "# error: allocation of " << mem << " bytes failed"
-                    << std::endl;
-                std::cerr << msg.str();
+                int exit_code = report_allocation_error(mem,
+                                                        options.lock_mode);
+                if (is_sweep) {
+                    has_failed = 1;
+                    break;
+                }
 #ifndef NO_MPI
-                MPI_Abort(MPI_COMM_WORLD, EXIT_MEM_ERROR);
+                MPI_Abort(MPI_COMM_WORLD, exit_code);
 #endif
-                std::exit(EXIT_MEM_ERROR);
+                std::exit(exit_code);
             }
         }
     }
-    std::chrono::microseconds period(lifetime);
+    event_log.reset();
+    if (options.lock_mode == LOCK_ALL) {
+        munlockall();
+    }
+    std::chrono::microseconds period(options.lifetime);
     std::this_thread::sleep_for(period);
     delete[] max_sizes;
     delete[] increments;
@@ -304,174 +735,345 @@ int main(int argc, char *argv[]) {
 #ifndef NO_MPI
     MPI_Barrier(MPI_COMM_WORLD);
 #endif
-    if (conf_file_allocated && conf_file_name != nullptr) {
-        delete[] conf_file_name;
-    }
-    if (rank == root) {
-        std::stringstream msg;
-        msg << "successfully done" << std::endl;
-        std::cout << msg.str();
-    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - run_start;
+    result.nr_threads = nr_threads;
+    result.nr_steps = nr_steps;
+    result.bytes_filled = bytes_filled;
+    result.nr_bad_pages = nr_bad_pages;
+    result.has_failed = has_failed;
+    result.fill_time = fill_time;
+    result.elapsed = elapsed.count();
 #ifndef NO_MPI
-    MPI_Finalize();
+    unsigned long local_counts[] {result.nr_threads, result.nr_steps,
+                                  result.bytes_filled, result.nr_bad_pages};
+    unsigned long counts[4];
+    MPI_Reduce(local_counts, counts, 4, MPI_UNSIGNED_LONG, MPI_SUM,
+               root, MPI_COMM_WORLD);
+    result.nr_threads = counts[0];
+    result.nr_steps = counts[1];
+    result.bytes_filled = counts[2];
+    result.nr_bad_pages = counts[3];
+    MPI_Reduce(&has_failed, &result.has_failed, 1, MPI_UNSIGNED_LONG,
+               MPI_MAX, root, MPI_COMM_WORLD);
+    MPI_Reduce(&fill_time, &result.fill_time, 1, MPI_DOUBLE, MPI_SUM,
+               root, MPI_COMM_WORLD);
+    double local_elapsed {result.elapsed};
+    MPI_Reduce(&local_elapsed, &result.elapsed, 1, MPI_DOUBLE, MPI_MAX,
+               root, MPI_COMM_WORLD);
 #endif
-    return 0;
+    if (options.is_verifying && rank == root && result.nr_bad_pages > 0) {
+        std::stringstream msg;
+        msg << "# error: verification found " << result.nr_bad_pages
+            << " mismatching pages" << std::endl;
+        std::cerr << msg.str();
+    }
+    return result;
 }
 
-size_t convert_size(const char *size_spec) {
-    std::stringstream stream;
-    stream.str(size_spec);
-    size_t number {0};
-    stream >> number;
-    std::string unit;
-    stream >> unit;
-    if (unit != "") {
-        std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
-        if (unit == "kb") {
-            number *= 1024;
-        } else if (unit == "mb") {
-            number *= 1024*1024;
-        } else if (unit == "gb") {
-            number *= 1024*1024*1024;
-        } else if (unit != "b") {
-            throw std::invalid_argument("unknown unit");
-        }
-    }
-    return number;
+// header of the results table of a sweep
+void write_results_header(std::ostream& out) {
+    out << "scenario,options,status,processes,threads,steps,"
+        << "bytes_filled,fill_bandwidth,mismatching_pages,elapsed,"
+        << "burst_time,burst_high_events,burst_oom_kill_events"
+        << std::endl;
 }
 
-long convert_time(const char *time_spec) {
-    std::stringstream stream;
-    stream.str(time_spec);
-    long number {0};
-    stream >> number;
-    std::string unit;
-    stream >> unit;
-    if (unit != "") {
-        std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
-        if (unit == "s") {
-            number *= 1000000;
-        } else if (unit == "ms") {
-            number *= 1000;
-        } else if (unit == "m") {
-            number *= 60*1000000;
-        } else if (unit != "us") {
-            throw std::invalid_argument("unknown unit");
+// CSV line of a scenario in the results table, flushed right away
+void write_result(std::ostream& out, int scenario_nr,
+                  const std::string& scenario, int nr_processes,
+                  const RunResult& result) {
+    double bandwidth = result.fill_time > 0.0 ?
+        result.bytes_filled/result.fill_time/1.0e9 : 0.0;
+    std::stringstream line;
+    line << scenario_nr << ",\"" << scenario << "\","
+         << (result.has_failed ? "failed" : "ok") << ","
+         << nr_processes << "," << result.nr_threads << ","
+         << result.nr_steps << "," << result.bytes_filled << ","
+         << bandwidth << "," << result.nr_bad_pages << ","
+         << result.elapsed << "," << result.burst_time;
+    for (int event: {CGROUP_EVENT_HIGH, CGROUP_EVENT_OOM_KILL}) {
+        line << ",";
+        if (result.burst_events[event] == CGROUP_EVENT_UNAVAILABLE) {
+            line << "n/a";
+        } else {
+            line << result.burst_events[event];
         }
     }
-    return number;
+    out << line.str() << std::endl;
 }
 
-char* allocate_memory(size_t size) {
-    char* buffer {nullptr};
-    if ((buffer = static_cast<char*>(malloc(size * sizeof(char)))) == nullptr) {
-        std::stringstream ss;
-        ss << "can't allocate memory (" << size << " bytes)";
-        throw std::runtime_error(ss.str());
+void report_event(EventLog *event_log, Event& event,
+                  const char *processor_name) {
+    if (event_log != nullptr) {
+        event_log->log(event);
+    } else {
+        std::cout << format_event(event, processor_name);
     }
-    return buffer;
 }
 
-void fill_memory(char *buffer, size_t size) {
-    char fill = 'A';
-    for (size_t i = 0; i < size; i++) {
-        buffer[i] = fill;
-        fill = fill == 'Z' ? 'A' : fill + 1;
+size_t report_verify(const char *buffer, size_t size, Event event,
+                     EventLog *event_log, const char *processor_name) {
+    std::vector<const char*> bad_pages;
+    auto start = std::chrono::steady_clock::now();
+    size_t nr_bad_pages = verify_memory(buffer, size, bad_pages,
+                                        MAX_REPORTED_MISMATCHES);
+    auto end = std::chrono::steady_clock::now();
+    event.cpu = sched_getcpu();
+    event.type = EVENT_VERIFIED;
+    event.size = size;
+    event.data[0] = nr_bad_pages;
+    event.data[1] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            end - start).count();
+    report_event(event_log, event, processor_name);
+    for (size_t i = 0; i < bad_pages.size(); i++) {
+        event.type = EVENT_MISMATCH;
+        event.size = 0;
+        event.data[0] = reinterpret_cast<uintptr_t>(bad_pages[i]);
+        report_event(event_log, event, processor_name);
+    }
+    if (nr_bad_pages > bad_pages.size()) {
+        event.type = EVENT_MISMATCH_MORE;
+        event.size = 0;
+        event.data[0] = nr_bad_pages - bad_pages.size();
+        report_event(event_log, event, processor_name);
     }
+    return nr_bad_pages;
 }
 
-void fill_memory_threaded(char *buffer, size_t size) {
-    char fill = 'A';
-#pragma omp for
-    for (size_t i = 0; i < size; i++) {
-        buffer[i] = fill;
-        fill = fill == 'Z' ? 'A' : fill + 1;
-    }
+void report_lock(char *buffer, size_t size, int lock_mode, Event event,
+                 EventLog *event_log, const char *processor_name) {
+    auto start = std::chrono::steady_clock::now();
+    lock_memory(buffer, size, lock_mode);
+    auto end = std::chrono::steady_clock::now();
+    event.cpu = sched_getcpu();
+    event.type = EVENT_LOCKED;
+    event.size = lock_mode == LOCK_ALL ? locked_memory_size() : size;
+    event.data[0] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            end - start).count();
+    event.data[1] = lock_mode;
+    report_event(event_log, event, processor_name);
 }
 
-std::vector<std::string> split(const std::string& str,
-                               const std::string& delim) {
-    std::vector<std::string> parts;
-    size_t pos = 0, old_pos = 0;
-    while ((pos = str.find(delim, old_pos)) != std::string::npos) {
-        parts.push_back(str.substr(old_pos, pos - old_pos));
-        old_pos = pos + delim.length();
-    }
-    parts.push_back(str.substr(old_pos));
-    return parts;
+// with all memory locked, the kernel refuses allocations that exceed the
+// limit on locked memory, so these are reported as lock errors; returns
+// the exit code for the error
+int report_allocation_error(size_t size, int lock_mode) {
+    int error = errno;
+    std::stringstream msg;
+    msg << "# error: allocation of " << size << " bytes failed";
+    if (lock_mode == LOCK_ALL) {
+        msg << " with all memory locked, " << strerror(error) << " ("
+            << lock_status() << ")" << std::endl;
+        std::cerr << msg.str();
+        return EXIT_LOCK_ERROR;
+    }
+    msg << std::endl;
+    std::cerr << msg.str();
+    return EXIT_MEM_ERROR;
 }
 
-void parse_config(const std::string& file_name, int target_line_nr,
-                  size_t& max_size, size_t& increment, long& sleeptime,
-                  int& nr_threads, size_t** max_sizes,
-                  size_t** increments, long** sleeptimes) {
-    std::regex comment_re {R"(^\s*#)"};
-    std::regex empty_re {R"(^\s*$)"};
-    std::ifstream config_file;
-    config_file.open(file_name);
-    if (!config_file.is_open()) {
-        std::stringstream ss;
-        ss << "unable to open configuration file '" << file_name << "'";
-        throw std::runtime_error(ss.str());
+void report_ramp(int rank, int nr_threads, size_t stack_size, int touches) {
+    std::string error;
+    size_t initial_rss = resident_set_size();
+    std::vector<RampStep> steps = ramp_threads(nr_threads, stack_size,
+                                               touches, error);
+    std::stringstream msg;
+    size_t rss = initial_rss;
+    double total_time {0.0};
+    double total_touch_time {0.0};
+    for (size_t thread_nr = 0; thread_nr < steps.size(); thread_nr++) {
+        msg << "rank " << rank << " ramp: "
+            << "thread " << thread_nr << " started in "
+            << steps[thread_nr].creation_time << " s, "
+            << "touched in " << steps[thread_nr].touch_time << " s, "
+            << "rss " << steps[thread_nr].rss << " bytes, "
+            << static_cast<long>(steps[thread_nr].rss - rss)
+            << " bytes added" << std::endl;
+        rss = steps[thread_nr].rss;
+        total_time += steps[thread_nr].creation_time;
+        total_touch_time += steps[thread_nr].touch_time;
     }
-    int line_nr {0};
-    std::string line;
-    while (config_file) {
-        std::string curr_line;
-        std::getline(config_file, curr_line);
-        std::smatch match;
-        if (std::regex_search(curr_line, match, empty_re))
-            continue;
-        if (std::regex_search(curr_line, match, comment_re))
-            continue;
-        line = curr_line;
-        if (line_nr++ == target_line_nr)
-            break;
+    if (!error.empty()) {
+        msg << "# warning rank " << rank << ": "
+            << "ramp stopped at thread " << steps.size() << ", "
+            << error << std::endl;
     }
-    config_file.close();
-    if (line_nr <= target_line_nr) {
-        std::stringstream ss;
-        ss << "requested line " << target_line_nr
-           << " not found in configuration file '" << file_name << "'";
-        throw std::runtime_error(ss.str());
+    if (!steps.empty()) {
+        msg << "rank " << rank << " ramp: "
+            << steps.size() << " threads, "
+            << "stack size " << stack_size << ", "
+            << "touching " << touches_to_string(touches) << ", "
+            << "mean start time " << total_time/steps.size() << " s, "
+            << "mean touch time " << total_touch_time/steps.size() << " s, "
+            << static_cast<long>(rss - initial_rss)/
+               static_cast<long>(steps.size())
+            << " bytes per thread" << std::endl;
     }
-    if (line.length() > 0) {
-        std::vector<std::string> parts = split(line, ";");
-        if (parts.size() == 2) {
-            max_size = 0;
-            increment = 0;
-            sleeptime = 0;
-            nr_threads = std::stoi(parts.at(0));
-            parts = split(parts.at(1), ":");
-        } else if (parts.size() == 3) {
-            std::vector<std::string> specs = split(parts.at(0), "+");
-            max_size = convert_size(specs.at(0).c_str());
-            increment = convert_size(specs.at(1).c_str());
-            sleeptime = convert_time(specs.at(2).c_str());
-            nr_threads = std::stoi(parts.at(1));
-            parts = split(parts.at(2), ":");
+    std::cout << msg.str();
+}
+
+// after the warm-up, the threads of all processes are released together
+// and each allocates and touches a block; the time until the blocks of
+// all threads of a process are resident, and the memory cgroup events
+// during the burst are gathered on the root process
+unsigned long report_burst(const Options& options, int rank, int nr_threads,
+                           bool is_sweep, RunResult& result) {
+    const int root {0};
+    std::chrono::microseconds warmup(options.burst_warmup);
+    std::this_thread::sleep_for(warmup);
+    uint64_t initial_events[NR_CGROUP_EVENTS];
+    read_cgroup_events(initial_events);
+    std::vector<char*> buffers(nr_threads, nullptr);
+    std::chrono::steady_clock::time_point release;
+    double time_to_resident {0.0};
+    unsigned long has_failed {0};
+#pragma omp parallel reduction(max:time_to_resident,has_failed)
+    {
+        int thread_nr {0};
+#ifdef _OPENMP
+        thread_nr = omp_get_thread_num();
+#endif
+#pragma omp master
+        {
+#ifndef NO_MPI
+            MPI_Barrier(MPI_COMM_WORLD);
+#endif
+            release = std::chrono::steady_clock::now();
         }
-        *max_sizes = new size_t[nr_threads];
-        *increments = new size_t[nr_threads];
-        *sleeptimes = new long[nr_threads];
-        size_t i {0};
-        for (i = 0; i < parts.size() && ((int) i) < nr_threads; i++) {
-            std::vector<std::string> specs = split(parts.at(i), "+");
-            (*max_sizes)[i] = convert_size(specs.at(0).c_str());
-            (*increments)[i] = convert_size(specs.at(1).c_str());
-            (*sleeptimes)[i] = convert_time(specs.at(2).c_str());
+#pragma omp barrier
+        try {
+            buffers[thread_nr] = allocate_memory(options.burst_size);
+            touch_memory(buffers[thread_nr], options.burst_size);
+            std::chrono::duration<double> duration =
+                std::chrono::steady_clock::now() - release;
+            time_to_resident = duration.count();
+        } catch (const std::runtime_error& e) {
+            int exit_code = report_allocation_error(options.burst_size,
+                                                    options.lock_mode);
+            if (is_sweep) {
+                has_failed = 1;
+            } else {
+#ifndef NO_MPI
+                MPI_Abort(MPI_COMM_WORLD, exit_code);
+#endif
+                std::exit(exit_code);
+            }
         }
-        for (int j = i; j < nr_threads; j++) {
-            (*max_sizes)[j] = (*max_sizes)[i - 1];
-            (*increments)[j] = (*increments)[i - 1];
-            (*sleeptimes)[j] = (*sleeptimes)[i - 1];
+    }
+    size_t rss = resident_set_size();
+    // blocks are kept until all processes are done, so that the peak is
+    // reached on all nodes at once
+#ifndef NO_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    uint64_t events[NR_CGROUP_EVENTS];
+    read_cgroup_events(events);
+    for (int event = 0; event < NR_CGROUP_EVENTS; event++) {
+        if (initial_events[event] != CGROUP_EVENT_UNAVAILABLE &&
+                events[event] != CGROUP_EVENT_UNAVAILABLE) {
+            events[event] -= initial_events[event];
+        } else {
+            events[event] = CGROUP_EVENT_UNAVAILABLE;
         }
-    } else {
-        std::stringstream ss;
-        ss << "unable to parse configuration line " << target_line_nr
-           << " in '" << file_name << "'";
-        throw std::runtime_error(ss.str());
     }
+    for (auto buffer: buffers)
+        free(buffer);
+    {
+        size_t bytes = nr_threads*options.burst_size;
+        std::stringstream msg;
+        msg << "rank " << rank << " burst: "
+            << nr_threads << " threads touched " << options.burst_size
+            << " bytes each in " << time_to_resident << " s, "
+            << (time_to_resident > 0.0 ?
+                bytes/time_to_resident/1.0e9 : 0.0) << " GB/s, "
+            << "rss " << rss << " bytes, "
+            << "cgroup events " << format_cgroup_events(events) << std::endl;
+        std::cout << msg.str();
+    }
+    int nr_ranks {1};
+    std::vector<double> times {time_to_resident};
+    std::vector<uint64_t> rank_events(events, events + NR_CGROUP_EVENTS);
+#ifndef NO_MPI
+    MPI_Comm_size(MPI_COMM_WORLD, &nr_ranks);
+    times.resize(nr_ranks);
+    rank_events.resize(nr_ranks*NR_CGROUP_EVENTS);
+    MPI_Gather(&time_to_resident, 1, MPI_DOUBLE, times.data(), 1, MPI_DOUBLE,
+               root, MPI_COMM_WORLD);
+    MPI_Gather(events, NR_CGROUP_EVENTS, MPI_UINT64_T, rank_events.data(),
+               NR_CGROUP_EVENTS, MPI_UINT64_T, root, MPI_COMM_WORLD);
+#endif
+    if (rank == root) {
+        // processes in the same cgroup see the same events, so the
+        // maximum over the processes is reported rather than the sum
+        for (int event = 0; event < NR_CGROUP_EVENTS; event++) {
+            for (int rank_nr = 0; rank_nr < nr_ranks; rank_nr++) {
+                uint64_t value = rank_events[rank_nr*NR_CGROUP_EVENTS + event];
+                if (value != CGROUP_EVENT_UNAVAILABLE &&
+                        (result.burst_events[event] ==
+                             CGROUP_EVENT_UNAVAILABLE ||
+                         value > result.burst_events[event])) {
+                    result.burst_events[event] = value;
+                }
+            }
+        }
+        BurstStatistics stats = burst_statistics(times);
+        result.burst_time = stats.max;
+        std::stringstream msg;
+        msg << "burst: " << nr_ranks << " processes, "
+            << "time to resident min " << stats.min << " s, "
+            << "median " << stats.median << " s, "
+            << "mean " << stats.mean << " s, "
+            << "p90 " << stats.p90 << " s, "
+            << "max " << stats.max << " s (rank " << stats.max_rank << ")"
+            << std::endl;
+        msg << "burst: cgroup events "
+            << format_cgroup_events(result.burst_events) << std::endl;
+        std::cout << msg.str();
+    }
+    return has_failed;
+}
+
+void report_counters(PerfCounters *counters, Event event,
+                     CounterPhase phase, EventLog *event_log,
+                     const char *processor_name) {
+    uint64_t values[NR_PERF_COUNTERS];
+    counters->stop(values);
+    event.type = EVENT_COUNTERS;
+    for (int counter = 0; counter < NR_PERF_COUNTERS; counter++)
+        event.data[counter] = values[counter];
+    event.data[6] = phase;
+    report_event(event_log, event, processor_name);
+}
+
+// report counters that can't be used on this process, e.g., due to
+// perf_event_paranoid or the lack of a hardware PMU in a virtual machine
+void warn_counters(int rank) {
+    PerfCounters counters;
+    std::stringstream unavailable;
+    std::stringstream user_only;
+    for (int counter = 0; counter < NR_PERF_COUNTERS; counter++) {
+        if (!counters.is_available(counter)) {
+            unavailable << " " << PERF_COUNTER_NAMES[counter] << " ("
+                        << strerror(counters.error(counter)) << ")";
+        } else if (counters.is_user_only(counter)) {
+            user_only << " " << PERF_COUNTER_NAMES[counter];
+        }
+    }
+    std::stringstream msg;
+    if (!unavailable.str().empty()) {
+        msg << "# warning rank " << rank << ": "
+            << "counters unavailable:" << unavailable.str()
+            << ", perf_event_paranoid = " << perf_event_paranoid()
+            << std::endl;
+    }
+    if (!user_only.str().empty()) {
+        msg << "# warning rank " << rank << ": "
+            << "counting user space only:" << user_only.str()
+            << ", perf_event_paranoid = " << perf_event_paranoid()
+            << std::endl;
+    }
+    std::cout << msg.str();
 }
 
 void print_help() {
@@ -479,7 +1081,10 @@ void print_help() {
     msg << "Usage: mem_limit [-v] [-h] ( "
         << "-f <conf_file> | \\" << std::endl
         << "\t\t( -m <size> [-i <size>] [-s <time>] [-t <n>] )) "
-        << "[-l <time>] "
+        << "[-l <time>] [-c] [-p] [-L <mode>] \\" << std::endl
+        << "\t\t[-e <prefix>] [-r <n> [-k <size>] [-x <touches>]] "
+        << "[-b <size> [-u <time>]]" << std::endl
+        << "       mem_limit [options] -w <sweep_file> [-o <file>]"
         << std::endl;
     msg << "\t-f <conf_file>: configuration file to use" << std::endl;
     msg << "\t-m <size>: maximum memory size" << std::endl;
@@ -487,6 +1092,28 @@ void print_help() {
     msg << "\t-s <time>: time to sleep between steps" << std::endl;
     msg << "\t-t <n>: number of threads per process" << std::endl;
     msg << "\t-l <time>: time to stay alive after last step" << std::endl;
+    msg << "\t-c: verify memory contents after fill and before release"
+        << std::endl;
+    msg << "\t-L <mode>: lock memory after allocation, mode is none, "
+        << "mlock, onfault (mlock2) or all (mlockall)" << std::endl;
+    msg << "\t-p: report performance counters for each allocation and "
+        << "fill" << std::endl;
+    msg << "\t-e <prefix>: log events to binary file <prefix>.<rank>.evt "
+        << "instead of standard output" << std::endl;
+    msg << "\t-r <n>: start n threads one by one, and report start time "
+        << "and resident memory per thread" << std::endl;
+    msg << "\t-k <size>: stack size for -r, default is the system default"
+        << std::endl;
+    msg << "\t-x <touches>: comma separated list of stack, arena "
+        << "to touch by each thread for -r" << std::endl;
+    msg << "\t-b <size>: all threads of all processes allocate and touch "
+        << "a block of this size at once, and report the time until it "
+        << "is resident" << std::endl;
+    msg << "\t-u <time>: warm-up time before the burst of -b" << std::endl;
+    msg << "\t-w <sweep_file>: run each scenario in the file, one per line"
+        << std::endl;
+    msg << "\t-o <file>: write the results table of -w to file, default "
+        << "is standard output" << std::endl;
     msg << "\t-v: give verbose output" << std::endl;
     msg << "\t-h: show this help message" << std::endl;
     msg << "<size> takes units b, kb, mb, gb, default is bytes"
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "mem_utils.h"
+
+// exit codes for application
+const int EXIT_OPT_ERROR {1};
+const int EXIT_CONFIG_ERROR {2};
+
+// smallest buffer size benchmarked, sizes increase by a factor
+const size_t MIN_BENCH_SIZE {4*1024};
+const size_t BENCH_SIZE_FACTOR {16};
+
+// number of calls per repetition for the conversion benchmarks
+const int NR_CONVERSIONS {100000};
+
+struct Timing {
+    double min;
+    double mean;
+    double max;
+};
+
+// cleanup is called after each repetition, outside of the timed region
+template<typename F, typename C>
+Timing time_kernel(int nr_reps, F kernel, C cleanup) {
+    Timing timing {0.0, 0.0, 0.0};
+    for (int rep = 0; rep < nr_reps; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto end = std::chrono::steady_clock::now();
+        cleanup();
+        std::chrono::duration<double> duration = end - start;
+        if (rep == 0 || duration.count() < timing.min)
+            timing.min = duration.count();
+        if (rep == 0 || duration.count() > timing.max)
+            timing.max = duration.count();
+        timing.mean += duration.count();
+    }
+    timing.mean /= nr_reps;
+    return timing;
+}
+
+template<typename F>
+Timing time_kernel(int nr_reps, F kernel) {
+    return time_kernel(nr_reps, kernel, [] () {});
+}
+
+void print_header();
+void print_result(const std::string& kernel, const std::string& variant,
+                  size_t size, int nr_reps, const Timing& timing,
+                  double rate, const std::string& unit);
+void bench_fill(size_t size, int nr_reps);
+void bench_allocate(size_t size, int nr_reps);
+void bench_convert(int nr_reps);
+void bench_parse_config(int nr_lines, int nr_reps);
+void print_help();
+
+int main(int argc, char *argv[]) {
+    size_t max_size {256*1024*1024};
+    int nr_reps {10};
+    int nr_lines {100000};
+    char opt {'\0'};
+    while ((opt = getopt(argc, argv, "m:r:n:h")) != -1) {
+        try {
+            switch (opt) {
+                case 'm':
+                    max_size = convert_size(optarg);
+                    break;
+                case 'r':
+                    nr_reps = atoi(optarg);
+                    break;
+                case 'n':
+                    nr_lines = atoi(optarg);
+                    break;
+                case 'h':
+                    print_help();
+                    return 0;
+                default:
+                    std::stringstream msg;
+                    msg << "# error: unknown option '-" << opt << "'"
+                        << std::endl;
+                    std::cerr << msg.str();
+                    print_help();
+                    std::exit(EXIT_OPT_ERROR);
+            }
+        } catch (const std::invalid_argument& e) {
+            std::stringstream msg;
+            msg << "# error: invalid option value, " << e.what()
+                << std::endl;
+            std::cerr << msg.str();
+            print_help();
+            std::exit(EXIT_OPT_ERROR);
+        }
+    }
+    if (nr_reps < 1 || nr_lines < 1) {
+        std::cerr << "# error: -r and -n expect a positive number"
+                  << std::endl;
+        print_help();
+        std::exit(EXIT_OPT_ERROR);
+    }
+    print_header();
+    for (size_t size = MIN_BENCH_SIZE; size <= max_size;
+            size *= BENCH_SIZE_FACTOR) {
+        bench_fill(size, nr_reps);
+    }
+    for (size_t size = MIN_BENCH_SIZE; size <= max_size;
+            size *= BENCH_SIZE_FACTOR) {
+        bench_allocate(size, nr_reps);
+    }
+    bench_convert(nr_reps);
+    try {
+        bench_parse_config(nr_lines, nr_reps);
+    } catch (const std::exception& e) {
+        std::stringstream msg;
+        msg << "# error: " << e.what() << std::endl;
+        std::cerr << msg.str();
+        std::exit(EXIT_CONFIG_ERROR);
+    }
+    return 0;
+}
+
+void print_header() {
+    std::cout << "kernel,variant,size,repetitions,"
+              << "min_time,mean_time,max_time,rate,unit" << std::endl;
+}
+
+void print_result(const std::string& kernel, const std::string& variant,
+                  size_t size, int nr_reps, const Timing& timing,
+                  double rate, const std::string& unit) {
+    std::stringstream msg;
+    msg << kernel << "," << variant << "," << size << "," << nr_reps << ","
+        << timing.min << "," << timing.mean << "," << timing.max << ","
+        << rate << "," << unit << std::endl;
+    std::cout << msg.str();
+}
+
+// fill and read back a buffer that is already resident, so that page
+// faults are not part of the timing
+void bench_fill(size_t size, int nr_reps) {
+    char *buffer = allocate_memory(size);
+    fill_memory(buffer, size);
+    Timing timing = time_kernel(nr_reps, [=] () {
+        fill_memory(buffer, size);
+    });
+    print_result("fill_memory", "serial", size, nr_reps, timing,
+                 size/timing.min/1.0e9, "GB/s");
+    int nr_threads {1};
+#ifdef _OPENMP
+    nr_threads = omp_get_max_threads();
+#endif
+    timing = time_kernel(nr_reps, [=] () {
+#pragma omp parallel
+        fill_memory_threaded(buffer, size);
+    });
+    print_result("fill_memory_threaded",
+                 std::to_string(nr_threads) + "_threads", size, nr_reps,
+                 timing, size/timing.min/1.0e9, "GB/s");
+    fill_memory(buffer, size);
+    timing = time_kernel(nr_reps, [=] () {
+        std::vector<const char*> bad_pages;
+        verify_memory(buffer, size, bad_pages, 0);
+    });
+    print_result("verify_memory", "xxh64", size, nr_reps, timing,
+                 size/timing.min/1.0e9, "GB/s");
+    free(buffer);
+}
+
+// time to obtain a buffer from the allocator, and optionally to lock it,
+// the buffer is unlocked and released after each repetition, outside of
+// the timed region, so that at most one buffer is locked at a time
+void bench_allocate(size_t size, int nr_reps) {
+    for (int lock_mode: {LOCK_NONE, LOCK_MLOCK, LOCK_ONFAULT}) {
+        char *buffer {nullptr};
+        try {
+            Timing timing = time_kernel(nr_reps, [&] () {
+                buffer = allocate_memory(size);
+                if (lock_mode != LOCK_NONE)
+                    lock_memory(buffer, size, lock_mode);
+            }, [&] () {
+                unlock_memory(buffer, size, lock_mode);
+                free(buffer);
+                buffer = nullptr;
+            });
+            std::string variant {"malloc"};
+            if (lock_mode != LOCK_NONE)
+                variant += "+" + lock_mode_to_string(lock_mode);
+            print_result("allocate_memory", variant, size, nr_reps, timing,
+                         1.0/timing.min, "op/s");
+        } catch (const std::runtime_error& e) {
+            free(buffer);
+            std::stringstream msg;
+            msg << "# warning: " << e.what() << std::endl;
+            std::cerr << msg.str();
+        }
+    }
+}
+
+void bench_convert(int nr_reps) {
+    const std::vector<std::string> size_specs {
+        "4096", "512 kb", "100mb", "2 GB", "7b"
+    };
+    const std::vector<std::string> time_specs {
+        "100", "250 ms", "1s", "2 m", "7us"
+    };
+    size_t total {0};
+    Timing timing = time_kernel(nr_reps, [&] () {
+        for (int i = 0; i < NR_CONVERSIONS; i++)
+            total += convert_size(size_specs[i % size_specs.size()].c_str());
+    });
+    print_result("convert_size", "", NR_CONVERSIONS, nr_reps, timing,
+                 NR_CONVERSIONS/timing.min, "call/s");
+    timing = time_kernel(nr_reps, [&] () {
+        for (int i = 0; i < NR_CONVERSIONS; i++)
+            total += convert_time(time_specs[i % time_specs.size()].c_str());
+    });
+    print_result("convert_time", "", NR_CONVERSIONS, nr_reps, timing,
+                 NR_CONVERSIONS/timing.min, "call/s");
+    if (total == 0)
+        std::cerr << "# warning: conversions returned zero" << std::endl;
+}
+
+// parse the last line of a generated configuration file, so that the
+// whole file has to be scanned
+void bench_parse_config(int nr_lines, int nr_reps) {
+    char file_name[] = "/tmp/mem_limit_bench_XXXXXX";
+    int fd = mkstemp(file_name);
+    if (fd < 0)
+        throw std::runtime_error("can't create temporary configuration file");
+    close(fd);
+    std::ofstream config_file(file_name);
+    for (int line_nr = 0; line_nr < nr_lines; line_nr++) {
+        if (line_nr % 10 == 0)
+            config_file << "# process " << line_nr << std::endl << std::endl;
+        config_file << "4gb+0mb+1s;2;2gb+50mb+1s:1gb+10mb+100ms"
+                    << std::endl;
+    }
+    config_file.close();
+    Timing timing = time_kernel(nr_reps, [=] () {
+        size_t max_size {0}, increment {0};
+        long sleeptime {0};
+        int nr_threads {0};
+        size_t *max_sizes {nullptr}, *increments {nullptr};
+        long *sleeptimes {nullptr};
+        parse_config(file_name, nr_lines - 1, max_size, increment, sleeptime,
+                     nr_threads, &max_sizes, &increments, &sleeptimes);
+        delete[] max_sizes;
+        delete[] increments;
+        delete[] sleeptimes;
+    });
+    unlink(file_name);
+    print_result("parse_config", "", nr_lines, nr_reps, timing,
+                 nr_lines/timing.min, "line/s");
+}
+
+void print_help() {
+    std::stringstream msg;
+    msg << "Usage: mem_limit_bench [-h] [-m <size>] [-r <n>] [-n <n>]"
+        << std::endl;
+    msg << "\t-m <size>: largest buffer size, default 256mb" << std::endl;
+    msg << "\t-r <n>: number of repetitions per benchmark, default 10"
+        << std::endl;
+    msg << "\t-n <n>: number of lines in the configuration file, "
+        << "default 100000" << std::endl;
+    msg << "\t-h: show this help message" << std::endl;
+    msg << "<size> takes units b, kb, mb, gb, default is bytes"
+        << std::endl;
+    msg << "results are written to standard output in CSV format"
+        << std::endl;
+    std::cerr << msg.str();
+    std::cerr << std::endl;
+}
@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mem_utils.h"
+
+#ifndef MLOCK_ONFAULT
+#define MLOCK_ONFAULT 0x01
+#endif
+
+size_t convert_size(const char *size_spec) {
+    std::stringstream stream;
+    stream.str(size_spec);
+    size_t number {0};
+    stream >> number;
+    std::string unit;
+    stream >> unit;
+    if (unit != "") {
+        std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+        if (unit == "kb") {
+            number *= 1024;
+        } else if (unit == "mb") {
+            number *= 1024*1024;
+        } else if (unit == "gb") {
+            number *= 1024*1024*1024;
+        } else if (unit != "b") {
+            throw std::invalid_argument("unknown unit");
+        }
+    }
+    return number;
+}
+
+long convert_time(const char *time_spec) {
+    std::stringstream stream;
+    stream.str(time_spec);
+    long number {0};
+    stream >> number;
+    std::string unit;
+    stream >> unit;
+    if (unit != "") {
+        std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+        if (unit == "s") {
+            number *= 1000000;
+        } else if (unit == "ms") {
+            number *= 1000;
+        } else if (unit == "m") {
+            number *= 60*1000000;
+        } else if (unit != "us") {
+            throw std::invalid_argument("unknown unit");
+        }
+    }
+    return number;
+}
+
+char* allocate_memory(size_t size) {
+    char* buffer {nullptr};
+    if ((buffer = static_cast<char*>(malloc(size * sizeof(char)))) == nullptr) {
+        int error = errno;
+        std::stringstream ss;
+        ss << "can't allocate memory (" << size << " bytes)";
+        // keep errno for callers that report why malloc failed
+        errno = error;
+        throw std::runtime_error(ss.str());
+    }
+    return buffer;
+}
+
+// lock a buffer with mlock or mlock2(MLOCK_ONFAULT), or all current and
+// future mappings of the process with mlockall, in which case buffer and
+// size are ignored; when the kernel refuses, e.g.,
+// due to RLIMIT_MEMLOCK or a cgroup limit, a runtime_error describes
+// the limit and the amount of memory locked so far
+void lock_memory(char *buffer, size_t size, int lock_mode) {
+    int status {0};
+    if (lock_mode == LOCK_MLOCK) {
+        status = mlock(buffer, size);
+    } else if (lock_mode == LOCK_ONFAULT) {
+#ifdef SYS_mlock2
+        status = syscall(SYS_mlock2, buffer, size, MLOCK_ONFAULT);
+#else
+        status = -1;
+        errno = ENOSYS;
+#endif
+    } else if (lock_mode == LOCK_ALL) {
+        status = mlockall(MCL_CURRENT | MCL_FUTURE);
+    }
+    if (status != 0) {
+        int error = errno;
+        std::stringstream ss;
+        if (lock_mode == LOCK_ALL) {
+            ss << "can't lock all memory with mlockall";
+        } else {
+            ss << "can't lock " << size << " bytes with "
+               << lock_mode_to_string(lock_mode);
+        }
+        ss << ", " << strerror(error) << " (" << lock_status() << ")";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+// amount of memory locked by the process and its RLIMIT_MEMLOCK
+std::string lock_status() {
+    std::stringstream ss;
+    ss << locked_memory_size() << " bytes locked, RLIMIT_MEMLOCK ";
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+            limit.rlim_cur != RLIM_INFINITY) {
+        ss << limit.rlim_cur << " bytes";
+    } else {
+        ss << "unlimited";
+    }
+    return ss.str();
+}
+
+// unlock a buffer before it is freed, since malloc may reuse its pages;
+// memory locked with mlockall stays locked until munlockall
+void unlock_memory(char *buffer, size_t size, int lock_mode) {
+    if (lock_mode == LOCK_MLOCK || lock_mode == LOCK_ONFAULT) {
+        munlock(buffer, size);
+    }
+}
+
+int parse_lock_mode(const std::string& lock_spec) {
+    if (lock_spec == "none") {
+        return LOCK_NONE;
+    } else if (lock_spec == "mlock") {
+        return LOCK_MLOCK;
+    } else if (lock_spec == "onfault") {
+        return LOCK_ONFAULT;
+    } else if (lock_spec == "all") {
+        return LOCK_ALL;
+    } else {
+        throw std::invalid_argument("unknown lock mode '" + lock_spec + "'");
+    }
+}
+
+std::string lock_mode_to_string(int lock_mode) {
+    switch (lock_mode) {
+        case LOCK_MLOCK:
+            return "mlock";
+        case LOCK_ONFAULT:
+            return "onfault";
+        case LOCK_ALL:
+            return "all";
+        default:
+            return "none";
+    }
+}
+
+// VmLck of the process in bytes, 0 if it can't be determined
+size_t locked_memory_size() {
+    std::ifstream status_file("/proc/self/status");
+    std::string line;
+    while (std::getline(status_file, line)) {
+        if (line.compare(0, 6, "VmLck:") == 0) {
+            std::stringstream stream(line.substr(6));
+            size_t size {0};
+            stream >> size;
+            return size*1024;
+        }
+    }
+    return 0;
+}
+
+void fill_memory(char *buffer, size_t size) {
+    char fill = 'A';
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = fill;
+        fill = fill == 'Z' ? 'A' : fill + 1;
+    }
+}
+
+void fill_memory_threaded(char *buffer, size_t size) {
+    char fill = 'A';
+#pragma omp for
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = fill;
+        fill = fill == 'Z' ? 'A' : fill + 1;
+    }
+}
+
+// write a single byte per page, so that the buffer becomes resident as
+// fast as possible
+void touch_memory(char *buffer, size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    volatile char *page = buffer;
+    for (size_t offset = 0; offset < size; offset += page_size)
+        page[offset] = 'A';
+}
+
+// XXH64 constants and helpers, the checksum is only compared against
+// itself, so byte order does not matter
+const uint64_t XXH_PRIME_1 {0x9E3779B185EBCA87ULL};
+const uint64_t XXH_PRIME_2 {0xC2B2AE3D27D4EB4FULL};
+const uint64_t XXH_PRIME_3 {0x165667B19E3779F9ULL};
+const uint64_t XXH_PRIME_4 {0x85EBCA77C2B2AE63ULL};
+const uint64_t XXH_PRIME_5 {0x27D4EB2F165667C5ULL};
+
+static inline uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const char *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input*XXH_PRIME_2;
+    acc = xxh_rotl(acc, 31);
+    return acc*XXH_PRIME_1;
+}
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t value) {
+    acc ^= xxh_round(0, value);
+    return acc*XXH_PRIME_1 + XXH_PRIME_4;
+}
+
+uint64_t checksum(const char *buffer, size_t size) {
+    const char *p {buffer};
+    const char *end {buffer + size};
+    uint64_t hash {0};
+    if (size >= 32) {
+        uint64_t v1 {XXH_PRIME_1 + XXH_PRIME_2};
+        uint64_t v2 {XXH_PRIME_2};
+        uint64_t v3 {0};
+        uint64_t v4 {0 - XXH_PRIME_1};
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+        }
+        hash = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) +
+               xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        hash = xxh_merge_round(hash, v1);
+        hash = xxh_merge_round(hash, v2);
+        hash = xxh_merge_round(hash, v3);
+        hash = xxh_merge_round(hash, v4);
+    } else {
+        hash = XXH_PRIME_5;
+    }
+    hash += size;
+    for (; p + 8 <= end; p += 8) {
+        hash ^= xxh_round(0, xxh_read64(p));
+        hash = xxh_rotl(hash, 27)*XXH_PRIME_1 + XXH_PRIME_4;
+    }
+    if (p + 4 <= end) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        hash ^= static_cast<uint64_t>(value)*XXH_PRIME_1;
+        hash = xxh_rotl(hash, 23)*XXH_PRIME_2 + XXH_PRIME_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        hash ^= static_cast<unsigned char>(*p)*XXH_PRIME_5;
+        hash = xxh_rotl(hash, 11)*XXH_PRIME_1;
+    }
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// returns the number of mismatching pages, only the addresses of the
+// first max_bad_pages are stored in bad_pages
+size_t verify_memory(const char *buffer, size_t size,
+                     std::vector<const char*>& bad_pages,
+                     size_t max_bad_pages) {
+    const size_t period {'Z' - 'A' + 1};
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    std::vector<char> expected(page_size + period);
+    fill_memory(expected.data(), expected.size());
+    std::vector<uint64_t> page_checksums(period);
+    for (size_t phase = 0; phase < period; phase++) {
+        page_checksums[phase] = checksum(expected.data() + phase, page_size);
+    }
+    size_t nr_bad_pages {0};
+    size_t offset {0};
+    while (offset < size) {
+        const char *page = buffer + offset;
+        size_t page_offset = reinterpret_cast<uintptr_t>(page) % page_size;
+        size_t length = std::min(page_size - page_offset, size - offset);
+        size_t phase = offset % period;
+        uint64_t expected_checksum = length == page_size ?
+            page_checksums[phase] :
+            checksum(expected.data() + phase, length);
+        if (checksum(page, length) != expected_checksum) {
+            if (nr_bad_pages < max_bad_pages)
+                bad_pages.push_back(page - page_offset);
+            nr_bad_pages++;
+        }
+        offset += length;
+    }
+    return nr_bad_pages;
+}
+
+std::vector<std::string> split(const std::string& str,
+                               const std::string& delim) {
+    std::vector<std::string> parts;
+    size_t pos = 0, old_pos = 0;
+    while ((pos = str.find(delim, old_pos)) != std::string::npos) {
+        parts.push_back(str.substr(old_pos, pos - old_pos));
+        old_pos = pos + delim.length();
+    }
+    parts.push_back(str.substr(old_pos));
+    return parts;
+}
+
+void parse_config(const std::string& file_name, int target_line_nr,
+                  size_t& max_size, size_t& increment, long& sleeptime,
+                  int& nr_threads, size_t** max_sizes,
+                  size_t** increments, long** sleeptimes) {
+    std::regex comment_re {R"(^\s*#)"};
+    std::regex empty_re {R"(^\s*$)"};
+    std::ifstream config_file;
+    config_file.open(file_name);
+    if (!config_file.is_open()) {
+        std::stringstream ss;
+        ss << "unable to open configuration file '" << file_name << "'";
+        throw std::runtime_error(ss.str());
+    }
+    int line_nr {0};
+    std::string line;
+    while (config_file) {
+        std::string curr_line;
+        std::getline(config_file, curr_line);
+        std::smatch match;
+        if (std::regex_search(curr_line, match, empty_re))
+            continue;
+        if (std::regex_search(curr_line, match, comment_re))
+            continue;
+        line = curr_line;
+        if (line_nr++ == target_line_nr)
+            break;
+    }
+    config_file.close();
+    if (line_nr <= target_line_nr) {
+        std::stringstream ss;
+        ss << "requested line " << target_line_nr
+           << " not found in configuration file '" << file_name << "'";
+        throw std::runtime_error(ss.str());
+    }
+    if (line.length() > 0) {
+        std::vector<std::string> parts = split(line, ";");
+        if (parts.size() == 2) {
+            max_size = 0;
+            increment = 0;
+            sleeptime = 0;
+            nr_threads = std::stoi(parts.at(0));
+            parts = split(parts.at(1), ":");
+        } else if (parts.size() == 3) {
+            std::vector<std::string> specs = split(parts.at(0), "+");
+            max_size = convert_size(specs.at(0).c_str());
+            increment = convert_size(specs.at(1).c_str());
+            sleeptime = convert_time(specs.at(2).c_str());
+            nr_threads = std::stoi(parts.at(1));
+            parts = split(parts.at(2), ":");
+        }
+        *max_sizes = new size_t[nr_threads];
+        *increments = new size_t[nr_threads];
+        *sleeptimes = new long[nr_threads];
+        size_t i {0};
+        for (i = 0; i < parts.size() && ((int) i) < nr_threads; i++) {
+            std::vector<std::string> specs = split(parts.at(i), "+");
+            (*max_sizes)[i] = convert_size(specs.at(0).c_str());
+            (*increments)[i] = convert_size(specs.at(1).c_str());
+            (*sleeptimes)[i] = convert_time(specs.at(2).c_str());
+        }
+        for (int j = i; j < nr_threads; j++) {
+            (*max_sizes)[j] = (*max_sizes)[i - 1];
+            (*increments)[j] = (*increments)[i - 1];
+            (*sleeptimes)[j] = (*sleeptimes)[i - 1];
+        }
+    } else {
+        std::stringstream ss;
+        ss << "unable to parse configuration line " << target_line_nr
+           << " in '" << file_name << "'";
+        throw std::runtime_error(ss.str());
+    }
+}
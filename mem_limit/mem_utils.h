@@ -0,0 +1,37 @@
+#ifndef MEM_UTILS_HDR
+#define MEM_UTILS_HDR
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// how buffers are locked in memory after allocation
+const int LOCK_NONE {0};
+const int LOCK_MLOCK {1};
+const int LOCK_ONFAULT {2};
+const int LOCK_ALL {3};
+
+size_t convert_size(const char *size_spec);
+long convert_time(const char *time_spec);
+char* allocate_memory(size_t size);
+void lock_memory(char *buffer, size_t size, int lock_mode);
+void unlock_memory(char *buffer, size_t size, int lock_mode);
+int parse_lock_mode(const std::string& lock_spec);
+std::string lock_mode_to_string(int lock_mode);
+size_t locked_memory_size();
+std::string lock_status();
+void fill_memory(char *buffer, size_t size);
+void fill_memory_threaded(char *buffer, size_t size);
+void touch_memory(char *buffer, size_t size);
+uint64_t checksum(const char *buffer, size_t size);
+size_t verify_memory(const char *buffer, size_t size,
+                     std::vector<const char*>& bad_pages,
+                     size_t max_bad_pages);
+std::vector<std::string> split(const std::string& str,
+                               const std::string& delim);
+void parse_config(const std::string& file_name, int target_line_nr,
+                  size_t& max_size, size_t& increment, long& sleeptime,
+                  int& nr_threads, size_t** max_sizes,
+                  size_t** increments, long** sleeptimes);
+
+#endif
@@ -0,0 +1,163 @@
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf_counters.h"
+
+const char *PERF_COUNTER_NAMES[NR_PERF_COUNTERS] {
+    "cycles",
+    "instructions",
+    "dtlb_load_misses",
+    "dtlb_store_misses",
+    "llc_misses",
+    "page_faults",
+};
+
+// layout of a read of the group leader with the GROUP_READ_FORMAT
+struct GroupRead {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[NR_PERF_COUNTERS];
+};
+
+const uint64_t GROUP_READ_FORMAT {PERF_FORMAT_GROUP |
+                                  PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                  PERF_FORMAT_TOTAL_TIME_RUNNING};
+
+static void counter_attr(int counter, bool is_leader,
+                         perf_event_attr& attr) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.read_format = GROUP_READ_FORMAT;
+    // members follow the leader, which is enabled and disabled for the
+    // whole group
+    attr.disabled = is_leader ? 1 : 0;
+    switch (counter) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_DTLB_LOAD_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_DTLB_STORE_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_WRITE << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_PAGE_FAULTS:
+            attr.type = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+            break;
+    }
+}
+
+static int open_counter(perf_event_attr& attr, int group_fd) {
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+// the counters are opened as a single group, led by the first counter
+// that can be opened, normally cycles, so that they are scheduled on the
+// PMU together and count over the same interval
+PerfCounters::PerfCounters() : leader_fd_ {-1}, nr_grouped_ {0} {
+    for (int counter = 0; counter < NR_PERF_COUNTERS; counter++) {
+        perf_event_attr attr;
+        counter_attr(counter, leader_fd_ < 0, attr);
+        is_user_only_[counter] = false;
+        errors_[counter] = 0;
+        fds_[counter] = open_counter(attr, leader_fd_);
+        if (fds_[counter] < 0 && (errno == EACCES || errno == EPERM)) {
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            is_user_only_[counter] = true;
+            fds_[counter] = open_counter(attr, leader_fd_);
+        }
+        if (fds_[counter] < 0) {
+            errors_[counter] = errno;
+            continue;
+        }
+        if (leader_fd_ < 0)
+            leader_fd_ = fds_[counter];
+        group_[nr_grouped_++] = counter;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int counter = 0; counter < NR_PERF_COUNTERS; counter++)
+        if (fds_[counter] >= 0 && fds_[counter] != leader_fd_)
+            close(fds_[counter]);
+    if (leader_fd_ >= 0)
+        close(leader_fd_);
+}
+
+void PerfCounters::start() {
+    if (leader_fd_ >= 0) {
+        ioctl(leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+// when the group was multiplexed with other events on the PMU, i.e., it
+// ran for only part of the time it was enabled, the counts cover only
+// part of the interval, so all counters are reported as unavailable
+void PerfCounters::stop(uint64_t values[NR_PERF_COUNTERS]) {
+    for (int counter = 0; counter < NR_PERF_COUNTERS; counter++)
+        values[counter] = PERF_COUNTER_UNAVAILABLE;
+    if (leader_fd_ < 0)
+        return;
+    ioctl(leader_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    GroupRead group;
+    ssize_t size = read(leader_fd_, &group, sizeof(group));
+    if (size < static_cast<ssize_t>(3*sizeof(uint64_t) +
+                                    nr_grouped_*sizeof(uint64_t)) ||
+            group.nr != static_cast<uint64_t>(nr_grouped_) ||
+            group.time_running < group.time_enabled) {
+        return;
+    }
+    for (int i = 0; i < nr_grouped_; i++)
+        values[group_[i]] = group.values[i];
+}
+
+// returns the value of /proc/sys/kernel/perf_event_paranoid, or
+// INT_MIN when it can't be read
+int perf_event_paranoid() {
+    std::ifstream paranoid_file("/proc/sys/kernel/perf_event_paranoid");
+    int paranoid {0};
+    if (!(paranoid_file >> paranoid))
+        return INT_MIN;
+    return paranoid;
+}
+
+std::string format_counters(const uint64_t values[NR_PERF_COUNTERS]) {
+    std::stringstream ss;
+    for (int counter = 0; counter < NR_PERF_COUNTERS; counter++) {
+        if (counter > 0)
+            ss << " ";
+        ss << PERF_COUNTER_NAMES[counter] << "=";
+        if (values[counter] == PERF_COUNTER_UNAVAILABLE) {
+            ss << "n/a";
+        } else {
+            ss << values[counter];
+        }
+    }
+    return ss.str();
+}
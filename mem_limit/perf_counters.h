@@ -0,0 +1,51 @@
+#ifndef PERF_COUNTERS_HDR
+#define PERF_COUNTERS_HDR
+
+#include <cstdint>
+#include <string>
+
+enum PerfCounter {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_DTLB_LOAD_MISSES,
+    PERF_DTLB_STORE_MISSES,
+    PERF_LLC_MISSES,
+    PERF_PAGE_FAULTS,
+    NR_PERF_COUNTERS
+};
+
+extern const char *PERF_COUNTER_NAMES[NR_PERF_COUNTERS];
+
+// value reported for a counter that could not be opened
+const uint64_t PERF_COUNTER_UNAVAILABLE {UINT64_MAX};
+
+// counters for the calling thread, opened with perf_event_open as a
+// single group; when the kernel refuses to count kernel events, only user
+// space is counted, and counters that can't be opened at all, or a group
+// that was multiplexed, are reported as unavailable
+class PerfCounters {
+    public:
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        void start();
+        void stop(uint64_t values[NR_PERF_COUNTERS]);
+        bool is_available(int counter) const { return fds_[counter] >= 0; }
+        int error(int counter) const { return errors_[counter]; }
+        bool is_user_only(int counter) const {
+            return is_user_only_[counter];
+        }
+    private:
+        int leader_fd_;
+        int nr_grouped_;
+        int group_[NR_PERF_COUNTERS];   // counters in the order of the group
+        int fds_[NR_PERF_COUNTERS];
+        int errors_[NR_PERF_COUNTERS];
+        bool is_user_only_[NR_PERF_COUNTERS];
+};
+
+int perf_event_paranoid();
+std::string format_counters(const uint64_t values[NR_PERF_COUNTERS]);
+
+#endif
@@ -0,0 +1,135 @@
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <alloca.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mem_utils.h"
+#include "thread_ramp.h"
+
+struct RampState {
+    std::mutex mutex;
+    std::condition_variable cond;
+    int nr_started {0};
+    bool is_released {false};
+    size_t stack_size {0};
+    int touches {0};
+    std::chrono::steady_clock::time_point running;  // of the latest thread
+};
+
+static void touch_pages(volatile char *buffer, size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < size; i += page_size)
+        buffer[i] = 1;
+}
+
+static void* ramp_thread(void *arg) {
+    RampState *state = static_cast<RampState*>(arg);
+    // only one thread at a time is starting, so it can set the time
+    // without holding the lock, the ramp reads it after nr_started changed
+    state->running = std::chrono::steady_clock::now();
+    char *arena_block {nullptr};
+    if (state->touches & RAMP_TOUCH_STACK &&
+            state->stack_size > RAMP_STACK_MARGIN) {
+        size_t size = state->stack_size - RAMP_STACK_MARGIN;
+        touch_pages(static_cast<char*>(alloca(size)), size);
+    }
+    if (state->touches & RAMP_TOUCH_ARENA) {
+        arena_block = static_cast<char*>(malloc(RAMP_ARENA_SIZE));
+        if (arena_block != nullptr)
+            touch_pages(arena_block, RAMP_ARENA_SIZE);
+    }
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->nr_started++;
+        state->cond.notify_all();
+        state->cond.wait(lock, [state] () { return state->is_released; });
+    }
+    free(arena_block);
+    return nullptr;
+}
+
+std::vector<RampStep> ramp_threads(int nr_threads, size_t& stack_size,
+                                   int touches, std::string& error) {
+    std::vector<RampStep> steps;
+    std::vector<pthread_t> threads;
+    RampState state;
+    state.touches = touches;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    int status {0};
+    if (stack_size > 0 &&
+            (status = pthread_attr_setstacksize(&attr, stack_size)) != 0) {
+        error = strerror(status);
+        pthread_attr_destroy(&attr);
+        return steps;
+    }
+    pthread_attr_getstacksize(&attr, &stack_size);
+    state.stack_size = stack_size;
+    for (int thread_nr = 0; thread_nr < nr_threads; thread_nr++) {
+        pthread_t thread;
+        auto start = std::chrono::steady_clock::now();
+        if ((status = pthread_create(&thread, &attr, ramp_thread,
+                                     &state)) != 0) {
+            error = strerror(status);
+            break;
+        }
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.cond.wait(lock, [&state, thread_nr] () {
+                return state.nr_started > thread_nr;
+            });
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> creation_time = state.running - start;
+        std::chrono::duration<double> touch_time = end - state.running;
+        threads.push_back(thread);
+        steps.push_back({creation_time.count(), touch_time.count(),
+                         resident_set_size()});
+    }
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.is_released = true;
+        state.cond.notify_all();
+    }
+    for (auto thread: threads)
+        pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+    return steps;
+}
+
+int parse_touches(const std::string& touch_spec) {
+    int touches {0};
+    for (const auto& touch: split(touch_spec, ",")) {
+        if (touch == "stack") {
+            touches |= RAMP_TOUCH_STACK;
+        } else if (touch == "arena") {
+            touches |= RAMP_TOUCH_ARENA;
+        } else if (touch != "none") {
+            throw std::invalid_argument("unknown touch '" + touch + "'");
+        }
+    }
+    return touches;
+}
+
+std::string touches_to_string(int touches) {
+    std::string spec;
+    if (touches & RAMP_TOUCH_STACK)
+        spec += "stack,";
+    if (touches & RAMP_TOUCH_ARENA)
+        spec += "arena,";
+    return spec.empty() ? "none" : spec.substr(0, spec.length() - 1);
+}
+
+size_t resident_set_size() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages {0};
+    size_t resident_pages {0};
+    statm >> total_pages >> resident_pages;
+    return resident_pages*sysconf(_SC_PAGESIZE);
+}
@@ -0,0 +1,34 @@
+#ifndef THREAD_RAMP_HDR
+#define THREAD_RAMP_HDR
+
+#include <string>
+#include <vector>
+
+// what each thread touches once it is started
+const int RAMP_TOUCH_STACK {1};
+const int RAMP_TOUCH_ARENA {2};
+
+// size of the block allocated per thread for RAMP_TOUCH_ARENA
+const size_t RAMP_ARENA_SIZE {1024};
+
+// part of the stack that is not touched for RAMP_TOUCH_STACK, glibc
+// places the thread descriptor and static TLS at the top of the stack
+const size_t RAMP_STACK_MARGIN {64*1024};
+
+struct RampStep {
+    double creation_time;   // seconds until the thread is running
+    double touch_time;      // seconds the thread took to touch memory
+    size_t rss;             // resident set size after the touches
+};
+
+// start up to nr_threads threads one by one, each waits until all are
+// created; stack_size 0 selects the default and is set to the size used;
+// when a thread can't be created, the ramp stops and error is set to the
+// reason
+std::vector<RampStep> ramp_threads(int nr_threads, size_t& stack_size,
+                                   int touches, std::string& error);
+int parse_touches(const std::string& touch_spec);
+std::string touches_to_string(int touches);
+size_t resident_set_size();
+
+#endif
@@ -0,0 +1,106 @@
+import os
+import struct
+import sys
+import subprocess
+import tempfile
+import unittest
+
+MEM_LIMIT_DIR = os.path.join(os.path.dirname(__file__), '..', 'mem_limit')
+SCRIPT = os.path.join(MEM_LIMIT_DIR, 'convert_events.py')
+CHECK_PINNING = os.path.join(MEM_LIMIT_DIR, 'check_pinning.py')
+
+HEADER_FORMAT = '=8sii256s'
+EVENT_FORMAT = '=QQ8Qiiii'
+
+
+def event(time, event_type, rank, thread, cpu, size=0, data=()):
+    data = list(data) + [0]*(8 - len(data))
+    return struct.pack(EVENT_FORMAT, time, size, *(data + [event_type, rank,
+                                                           thread, cpu]))
+
+
+class ConvertEventsTests(unittest.TestCase):
+
+    def write_log(self, rank, events, magic=b'MLEVT001'):
+        with tempfile.NamedTemporaryFile('wb', delete=False) as f:
+            f.write(struct.pack(HEADER_FORMAT, magic, rank,
+                                struct.calcsize(EVENT_FORMAT), b'node1'))
+            for record in events:
+                f.write(record)
+            return f.name
+
+    def run_script(self, script, *args):
+        return subprocess.run([sys.executable, script, *args],
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                              text=True)
+
+    def test_text_format(self):
+        fname = self.write_log(0, [
+            event(20, 1, 0, 0, 3, size=1024),
+            event(10, 0, 0, 0, 3, size=1024),
+            event(30, 2, 0, 0, 3, size=1024, data=(1, 2000)),
+            event(40, 3, 0, 0, 3, data=(0x7f0000001000,)),
+            event(15, 6, 0, 0, 3, size=1024, data=(5000, 2)),
+        ])
+        try:
+            res = self.run_script(SCRIPT, fname)
+        finally:
+            os.unlink(fname)
+        self.assertEqual(res.returncode, 0)
+        self.assertEqual(res.stdout.splitlines(), [
+            'rank 0#0 on 3@node1: allocating 1024 bytes',
+            'rank 0#0 on 3@node1: locked 1024 bytes with onfault in 5e-06 s',
+            'rank 0#0 on 3@node1: filling 1024 bytes',
+            'rank 0#0 on 3@node1: verified 1024 bytes in 2e-06 s, '
+            '0.512 GB/s, 1 mismatching pages',
+            'rank 0#0 on 3@node1: mismatch in page 0x7f0000001000',
+        ])
+
+    def test_counters(self):
+        fname = self.write_log(1, [
+            event(10, 5, 1, 2, 4, size=4096,
+                  data=(100, 200, 2**64 - 1, 3, 4, 1, 1)),
+        ])
+        try:
+            res = self.run_script(SCRIPT, fname)
+        finally:
+            os.unlink(fname)
+        self.assertEqual(res.returncode, 0)
+        self.assertEqual(res.stdout.splitlines(), [
+            'rank 1#2 on 4@node1: counters fill 4096 bytes: cycles=100 '
+            'instructions=200 dtlb_load_misses=n/a dtlb_store_misses=3 '
+            'llc_misses=4 page_faults=1',
+        ])
+
+    def test_check_pinning(self):
+        fnames = [
+            self.write_log(0, [event(10, 0, 0, 0, 0, size=1),
+                               event(20, 0, 0, 0, 2, size=2)]),
+            self.write_log(1, [event(10, 0, 1, 0, 0, size=1)]),
+        ]
+        with tempfile.NamedTemporaryFile('w+', delete=False) as f:
+            output = f.name
+        try:
+            res = self.run_script(SCRIPT, '--frame', *fnames)
+            self.assertEqual(res.returncode, 0)
+            with open(output, 'w') as f:
+                f.write(res.stdout)
+            res = self.run_script(CHECK_PINNING, output)
+        finally:
+            for fname in fnames + [output]:
+                os.unlink(fname)
+        self.assertEqual(res.returncode, 0)
+        self.assertIn('Summary: 1/2 threads moved, 1 total moves', res.stdout)
+
+    def test_invalid_log(self):
+        fname = self.write_log(0, [], magic=b'NOTALOG!')
+        try:
+            res = self.run_script(SCRIPT, fname)
+        finally:
+            os.unlink(fname)
+        self.assertNotEqual(res.returncode, 0)
+        self.assertIn('error', res.stderr)
+
+
+if __name__ == '__main__':
+    unittest.main()